@@ -0,0 +1,324 @@
+#include "main.h"
+#include "debug.h"
+
+#include <time.h>
+
+// microbenchmarks for the hot paths, linked against the engine library.
+// every benchmark is warmed up, then timed in batches sized to take a few
+// milliseconds each, and the batches are summarised. the results go to
+// stdout as json so runs from different versions can be diffed, a readable
+// summary goes to stderr. an argument only runs the benchmarks whose name
+// contains it. a benchmark can have a time budget per unit, the run exits
+// with 1 when the median of one misses it
+
+static State *state;
+
+#include "common.c"
+#include "name.c"
+#include "rectangle.c"
+#include "fft.c"
+
+#define BENCH_WARMUP_SECONDS 0.2
+#define BENCH_SAMPLE_SECONDS 0.02
+#define BENCH_SAMPLE_COUNT 25
+#define BENCH_BLOCK_FRAMES 512
+#define BENCH_SCREEN_WIDTH 1280
+#define BENCH_SCREEN_HEIGHT 720
+#define BENCH_HIT_TEST_GRID 64
+// the spectrum runs one transform per frame
+#define BENCH_FFT_BUDGET_SECONDS 0.0005
+
+typedef struct Bench {
+    char name[64];
+    const char *unit;
+    void (*setup)(struct Bench *bench);
+    // runs count operations, returns how many units of work they were
+    uint64 (*run)(struct Bench *bench, uint64 count);
+    int arg;
+    // seconds one unit may take at most, 0 when there is no budget
+    double budget;
+} Bench;
+
+typedef struct BenchResult {
+    uint64 batch;
+    double rates[BENCH_SAMPLE_COUNT];
+    double median;
+    double mean;
+    double stddev;
+    double min;
+    double max;
+} BenchResult;
+
+static Engine *bench_engine;
+static volatile uint64 bench_sink;
+
+static double bench_now() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static int compare_rates(const void *a, const void *b) {
+    double x = *(const double *)a;
+    double y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+// a progression that goes round the circle, repeated on every row that is on
+static void bench_fill_sequencer(Engine *engine, int rows, int cells_per_row) {
+    static const uint8 progression[] = {
+        SCALE_DEGREE_I, SCALE_DEGREE_VI, SCALE_DEGREE_IV, SCALE_DEGREE_V,
+        SCALE_DEGREE_III, SCALE_DEGREE_VI, SCALE_DEGREE_II, SCALE_DEGREE_V,
+    };
+    for (int i = 0; i < SEQUENCER_ELEMENTS; i++) {
+        int row = i / SEQUENCER_ROW;
+        int column = i % SEQUENCER_ROW;
+        bool filled = row < rows && column < cells_per_row;
+        engine->sequencer[i] = filled ? progression[column % 8] : SCALE_DEGREE_NONE;
+    }
+    for (int i = 0; i < SEQUENCER_AMOUNT; i++) {
+        engine->sequencer_states[i] = i < rows;
+    }
+    engine->chord_idx = 0;
+}
+
+static void setup_engine_render(Bench *bench) {
+    engine_init(bench_engine);
+    bench_engine->vibe = bench->arg;
+    bench_fill_sequencer(bench_engine, 1, SEQUENCER_ROW);
+    bench_engine->playing = true;
+    publish_param_targets(bench_engine);
+}
+
+static uint64 run_engine_render(Bench *bench, uint64 count) {
+    int16 block[BENCH_BLOCK_FRAMES];
+    for (uint64 i = 0; i < count; i++) {
+        engine_render(bench_engine, block, BENCH_BLOCK_FRAMES);
+    }
+    bench_sink += block[0];
+    return count * BENCH_BLOCK_FRAMES;
+}
+
+static void setup_sequencer_chord(Bench *bench) {
+    engine_init(bench_engine);
+}
+
+// one op is every degree of every key, so 12 * scale types * 7 calls
+static uint64 run_sequencer_chord(Bench *bench, uint64 count) {
+    uint64 calls = 0;
+    for (uint64 i = 0; i < count; i++) {
+        for (int scale_type = 0; scale_type < SCALE_TYPE_COUNT; scale_type++) {
+            for (int root = 0; root < NOTE_COUNT; root++) {
+                bench_engine->scale_type = scale_type;
+                bench_engine->scale_root = root;
+                refresh_scale(bench_engine);
+                for (int degree = 0; degree < SCALE_DEGREE_COUNT; degree++) {
+                    bench_sink += get_sequencer_chord(bench_engine, degree).roman[0];
+                    calls++;
+                }
+            }
+        }
+    }
+    return calls;
+}
+
+// arg is how many cells of the first row are filled, a full grid when negative
+static void setup_progress(Bench *bench) {
+    engine_init(bench_engine);
+    if (bench->arg < 0) {
+        bench_fill_sequencer(bench_engine, SEQUENCER_AMOUNT, SEQUENCER_ROW);
+    } else {
+        bench_fill_sequencer(bench_engine, 1, bench->arg);
+    }
+}
+
+static uint64 run_progress(Bench *bench, uint64 count) {
+    for (uint64 i = 0; i < count; i++) {
+        progress(bench_engine);
+    }
+    bench_sink += bench_engine->chord_idx;
+    return count;
+}
+
+static void setup_fft(Bench *bench) {
+    fft_init(&state->fft);
+    for (int i = 0; i < FFT_SIZE; i++) {
+        state->spectrum_input[i] = 0.5f * sinf(2.0f * PI * 110.0f * i / SAMPLE_RATE) + 0.25f * sinf(2.0f * PI * 1375.0f * i / SAMPLE_RATE);
+    }
+}
+
+static uint64 run_fft(Bench *bench, uint64 count) {
+    for (uint64 i = 0; i < count; i++) {
+        fft_power_spectrum(&state->fft, state->spectrum_input, state->spectrum_power);
+    }
+    bench_sink += (uint64)state->spectrum_power[1];
+    return count;
+}
+
+static void setup_layout(Bench *bench) {
+    refresh_layout(BENCH_SCREEN_WIDTH, BENCH_SCREEN_HEIGHT);
+}
+
+static uint64 run_refresh_layout(Bench *bench, uint64 count) {
+    for (uint64 i = 0; i < count; i++) {
+        refresh_layout(BENCH_SCREEN_WIDTH - (i & 1), BENCH_SCREEN_HEIGHT);
+    }
+    bench_sink += state->layout.screen_width;
+    return count;
+}
+
+// one op is a grid of points over the whole window, most of them miss
+static uint64 run_hit_test(Bench *bench, uint64 count) {
+    uint64 tests = 0;
+    for (uint64 i = 0; i < count; i++) {
+        for (int y = 0; y < BENCH_HIT_TEST_GRID; y++) {
+            for (int x = 0; x < BENCH_HIT_TEST_GRID; x++) {
+                Vector2 position = {
+                    (x + 0.5f) * BENCH_SCREEN_WIDTH / BENCH_HIT_TEST_GRID,
+                    (y + 0.5f) * BENCH_SCREEN_HEIGHT / BENCH_HIT_TEST_GRID,
+                };
+                int section = 0;
+                if (bench->arg == 0) {
+                    bench_sink += get_sequencer_element_at(position, &section) + section;
+                } else if (bench->arg == 1) {
+                    bench_sink += get_sequencer_state_at(position, &section) + section;
+                } else {
+                    state->mouse_position = position;
+                    for (int control = 0; control < CONTROLS_COUNT; control++) {
+                        bench_sink += mouse_in_rectangle(get_control_value_rectangle(control));
+                    }
+                }
+                tests++;
+            }
+        }
+    }
+    return tests;
+}
+
+static int collect_benches(Bench *benches) {
+    int count = 0;
+
+    for (int vibe = 0; vibe < VIBE_COUNT; vibe++) {
+        Bench *bench = &benches[count++];
+        *bench = (Bench){ .unit = "frames", .setup = setup_engine_render, .run = run_engine_render, .arg = vibe };
+        snprintf(bench->name, sizeof(bench->name), "engine_render/%s", get_vibe_name(vibe));
+    }
+
+    benches[count++] = (Bench){ "get_sequencer_chord/all_keys", "calls", setup_sequencer_chord, run_sequencer_chord, 0 };
+
+    benches[count++] = (Bench){ "progress/sparse", "calls", setup_progress, run_progress, 2 };
+    benches[count++] = (Bench){ "progress/dense", "calls", setup_progress, run_progress, -1 };
+
+    benches[count++] = (Bench){ "fft/4096", "transforms", setup_fft, run_fft, 0, BENCH_FFT_BUDGET_SECONDS };
+
+    benches[count++] = (Bench){ "refresh_layout", "calls", setup_layout, run_refresh_layout, 0 };
+    benches[count++] = (Bench){ "hit_test/sequencer_element", "tests", setup_layout, run_hit_test, 0 };
+    benches[count++] = (Bench){ "hit_test/sequencer_state", "tests", setup_layout, run_hit_test, 1 };
+    benches[count++] = (Bench){ "hit_test/controls", "tests", setup_layout, run_hit_test, 2 };
+
+    return count;
+}
+
+static BenchResult run_bench(Bench *bench) {
+    BenchResult result = {0};
+    bench->setup(bench);
+
+    // doubles the batch through the warmup until one takes long enough
+    uint64 batch = 1;
+    double warmup_end = bench_now() + BENCH_WARMUP_SECONDS;
+    double batch_time = 0.0;
+    while (bench_now() < warmup_end || batch_time < BENCH_SAMPLE_SECONDS) {
+        double start = bench_now();
+        bench->run(bench, batch);
+        batch_time = bench_now() - start;
+        if (batch_time < BENCH_SAMPLE_SECONDS) {
+            batch *= 2;
+        }
+    }
+    result.batch = batch;
+
+    for (int i = 0; i < BENCH_SAMPLE_COUNT; i++) {
+        double start = bench_now();
+        uint64 units = bench->run(bench, batch);
+        double elapsed = bench_now() - start;
+        result.rates[i] = units / elapsed;
+    }
+
+    double sorted[BENCH_SAMPLE_COUNT];
+    memcpy(sorted, result.rates, sizeof(sorted));
+    qsort(sorted, BENCH_SAMPLE_COUNT, sizeof(double), compare_rates);
+    result.median = sorted[BENCH_SAMPLE_COUNT / 2];
+    result.min = sorted[0];
+    result.max = sorted[BENCH_SAMPLE_COUNT - 1];
+
+    double sum = 0.0;
+    for (int i = 0; i < BENCH_SAMPLE_COUNT; i++) {
+        sum += sorted[i];
+    }
+    result.mean = sum / BENCH_SAMPLE_COUNT;
+
+    double variance = 0.0;
+    for (int i = 0; i < BENCH_SAMPLE_COUNT; i++) {
+        double d = sorted[i] - result.mean;
+        variance += d * d;
+    }
+    result.stddev = sqrt(variance / (BENCH_SAMPLE_COUNT - 1));
+
+    return result;
+}
+
+int main(int argc, char **argv) {
+    const char *filter = (argc > 1) ? argv[1] : NULL;
+
+    state = calloc(1, sizeof(State));
+    bench_engine = calloc(1, sizeof(Engine));
+    engine_init(&state->engine);
+
+    Bench benches[32];
+    int bench_count = collect_benches(benches);
+
+    printf("{\n");
+    printf("  \"samples\": %i,\n", BENCH_SAMPLE_COUNT);
+    printf("  \"block_frames\": %i,\n", BENCH_BLOCK_FRAMES);
+    printf("  \"benchmarks\": [");
+
+    bool first = true;
+    int over_budget = 0;
+    for (int i = 0; i < bench_count; i++) {
+        Bench *bench = &benches[i];
+        if (filter != NULL && strstr(bench->name, filter) == NULL) {
+            continue;
+        }
+
+        BenchResult result = run_bench(bench);
+
+        printf("%s\n    {", first ? "" : ",");
+        printf(" \"name\": \"%s\", \"unit\": \"%s\", \"batch\": %llu,", bench->name, bench->unit, (unsigned long long)result.batch);
+        printf(" \"median\": %.1f, \"mean\": %.1f, \"stddev\": %.1f, \"min\": %.1f, \"max\": %.1f",
+            result.median, result.mean, result.stddev, result.min, result.max);
+        first = false;
+
+        fprintf(stderr, "%-32s %14.0f %s/s  (+- %.1f%%)",
+            bench->name, result.median, bench->unit, 100.0 * result.stddev / result.mean);
+
+        // the median has to make it, one slow batch does not fail the run
+        if (bench->budget > 0.0) {
+            double seconds = 1.0 / result.median;
+            bool within = seconds <= bench->budget;
+            printf(", \"seconds_per_unit\": %.9f, \"budget\": %.9f, \"within_budget\": %s", seconds, bench->budget, within ? "true" : "false");
+            fprintf(stderr, "  %.3fms of %.3fms%s", seconds * 1000.0, bench->budget * 1000.0, within ? "" : " OVER BUDGET");
+            if (!within) {
+                over_budget++;
+            }
+        }
+        printf(" }");
+        fprintf(stderr, "\n");
+    }
+
+    printf("\n  ]\n}\n");
+
+    engine_destroy(bench_engine);
+    free(bench_engine);
+    free(state);
+    return (over_budget == 0) ? 0 : 1;
+}
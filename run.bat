@@ -1,6 +1,7 @@
 @echo off
 
 set "main_c=.\src\main.c"
+set "engine_c=.\src\engine.c"
 set "raylib_dir=.\raylib"
 set "build_dir=.\build"
 set "main_exe=%build_dir%\main.exe"
@@ -22,10 +23,10 @@ for %%x in (%*) do (
 
 echo compiling...
 
-gcc %debug% %main_c% -o%main_exe% ^
+gcc %debug% %main_c% %engine_c% -o%main_exe% ^
     -I%raylib_dir%\include\ ^
     -L%raylib_dir%\lib\ ^
-    -lraylib -lopengl32 -lgdi32 -lwinmm
+    -lraylib -lopengl32 -lgdi32 -lwinmm -lpthread
 
 if errorlevel 1 (
     echo compilation failed horribly
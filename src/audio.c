@@ -0,0 +1,24 @@
+// the audio callback. the engine renders the block, everything else that
+// wants to hear it (scope, recorder, midi out) gets it from here
+
+static void audio_chord_played(void *data, const SynthParams *params, uint32 position, uint32 count, uint64 frame) {
+    midi_out_play((MidiOut *)data, params, position, count, frame);
+}
+
+void chord_synthesizer(void *buffer, unsigned int frames) {
+    rt_check_enter();
+    Engine *engine = &state->engine;
+    int16 *d = (int16 *)buffer;
+
+    uint64 frame = engine->frame;
+    engine->mute = atomic_load_explicit(&state->midi_out.mode, memory_order_relaxed) == MIDI_OUT_MODE_ONLY;
+    midi_out_anchor(&state->midi_out, frame);
+
+    if (!engine_render(engine, d, frames)) {
+        midi_out_stop(&state->midi_out, frame);
+    }
+
+    audio_tap_write(&state->audio_tap, d, frames);
+    recorder_push(&state->recorder, d, frames);
+    rt_check_leave();
+}
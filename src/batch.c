@@ -0,0 +1,73 @@
+// the frame is drawn into a render batch of its own instead of raylib's,
+// so what goes to the gpu can be counted. every flush of a batch moves it on
+// to its next vertex buffer, the buffer index shows flushes that rlgl does
+// without being asked (a full buffer, a texture or shader change somewhere
+// in raylib). what those sent is gone by the time it could be looked at, so
+// the draw calls and vertices only cover the flushes made from here. with a
+// few buffers the driver also does not have to wait for the gpu to finish
+// reading one before it gets filled again
+
+#define DRAW_BATCH_BUFFER_COUNT 8
+#define DRAW_BATCH_BUFFER_ELEMENTS 4096
+
+static rlRenderBatch draw_batch;
+static int draw_batch_buffer;
+
+void draw_batch_init() {
+    draw_batch = rlLoadRenderBatch(DRAW_BATCH_BUFFER_COUNT, DRAW_BATCH_BUFFER_ELEMENTS);
+}
+
+void draw_batch_unload() {
+    rlUnloadRenderBatch(draw_batch);
+}
+
+// the buffer index also moves when an empty batch is drawn, raylib does
+// that on every shader change
+static void draw_batch_sync() {
+    draw_batch_buffer = draw_batch.currentBuffer;
+}
+
+void draw_batch_begin() {
+    rlSetRenderBatchActive(&draw_batch);
+    draw_batch_sync();
+}
+
+void draw_batch_flush() {
+    ProfileFrame *frame = get_profile_frame(0);
+    frame->batch_flushes += (draw_batch.currentBuffer - draw_batch_buffer + DRAW_BATCH_BUFFER_COUNT) % DRAW_BATCH_BUFFER_COUNT;
+
+    uint32 draw_calls = 0;
+    uint32 vertices = 0;
+    for (int i = 0; i < draw_batch.drawCounter; i++) {
+        if (draw_batch.draws[i].vertexCount > 0) {
+            draw_calls++;
+            vertices += draw_batch.draws[i].vertexCount;
+        }
+    }
+    if (vertices > 0) {
+        frame->draw_calls += draw_calls;
+        frame->vertices += vertices;
+        frame->batch_flushes++;
+    }
+
+    rlDrawRenderBatch(&draw_batch);
+    draw_batch_sync();
+}
+
+void draw_batch_begin_shader(Shader shader) {
+    draw_batch_flush();
+    BeginShaderMode(shader);
+    draw_batch_sync();
+}
+
+void draw_batch_end_shader() {
+    draw_batch_flush();
+    EndShaderMode();
+    draw_batch_sync();
+}
+
+// back to raylib's batch for whatever comes after the frame
+void draw_batch_end() {
+    draw_batch_flush();
+    rlSetRenderBatchActive(NULL);
+}
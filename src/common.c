@@ -8,13 +8,11 @@ inline static bool mouse_in_rectangle(Rectangle rec) {
 }
 
 inline static float size_multiplier() {
-    int width = GetScreenWidth();
-    int height = GetScreenHeight();
-    return (width < height) ? width : height;
+    return state->layout.size_multiplier;
 }
 
 inline static float font_size() {
-    return 0.04f * size_multiplier();
+    return state->layout.font_size;
 }
 
 inline static bool has_flag(int flag) {
@@ -26,6 +24,6 @@ inline static void toggle_flag(int flag) {
 }
 
 inline static float get_thing_height() {
-    return GetScreenHeight() / VERTICAL_POSITION_COUNT;
+    return state->layout.thing_height;
 }
 
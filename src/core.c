@@ -1,148 +1,162 @@
-void init() {
+void init(int argc, char **argv) {
+    log_start();
+    rt_check_init();
 #ifndef DEBUG
     SetTraceLogLevel(LOG_WARNING);
 #endif
-    SetConfigFlags(FLAG_WINDOW_RESIZABLE);
-    InitWindow(1200, 800, WINDOW_NAME);
-    SetTargetFPS(60);
-
     state = (State *)calloc(1, sizeof(State));
-    state->state = STATE_MAIN;
-    state->vibe = VIBE_POLKA;
-    state->vibes_per_chord = 4;
-    refresh_time_per_chord_range();
-    state->time_per_chord = get_centralized_time_per_chord();
-    state->volume_manual = 0.5f;
-    state->scale_root = NOTE_C;
-    state->scale_type = SCALE_TYPE_MAJOR;
-
-    refresh_scale();
-
-    for (int i = 0; i < SEQUENCER_AMOUNT; i++) {
-        state->sequencer_states[i] = false;
-        for (int j = 0; j < SEQUENCER_ROW; j++) {
-            state->sequencer[(i * SEQUENCER_ROW) + j] = SCALE_DEGREE_NONE;
-        }
+    // the window still has to exist for the gl context
+    if (headless_parse_args(argc, argv)) {
+        SetConfigFlags(FLAG_WINDOW_HIDDEN);
+    } else {
+        SetConfigFlags(FLAG_WINDOW_RESIZABLE);
     }
+    InitWindow(1200, 800, WINDOW_NAME);
+    // raylib would wait for the frame inside EndDrawing, where the profiler
+    // cannot tell it from the swap. render() waits after it instead
+    SetTargetFPS(0);
+    state->frame_time = 1.0 / FRAME_RATE;
+    draw_batch_init();
 
-    int ascii_start = 32;
-    int ascii_end = 126;
-    int ascii_count = ascii_end - ascii_start + 1;
-
-    int extra_symbols[] = {
-        CHAR_SINGLE_8TH_NOTE,
-        CHAR_BEAMED_8TH_NOTES,
-        CHAR_SHARP,
-        CHAR_FLAT,
-        CHAR_DIMINISHED,
-    };
-
-    int extra_symbol_count = sizeof(extra_symbols) / sizeof(extra_symbols[0]);
-    int totalCount = ascii_count + extra_symbol_count;
-
-    int all_chars[totalCount];
-    for (int i = 0; i < ascii_count; i++) {
-        all_chars[i] = ascii_start + i;
-    }
+    refresh_layout(GetScreenWidth(), GetScreenHeight());
+    state->state = STATE_MAIN;
+    input_start(argc, argv);
 
-    for (int i = 0; i < extra_symbol_count; i++) {
-        all_chars[ascii_count + i] = extra_symbols[i];
+    engine_init(&state->engine);
+    engine_start_pcm_cache(&state->engine);
+    state->engine.chord_callback = audio_chord_played;
+    state->engine.chord_callback_data = &state->midi_out;
+    // recorded sessions start from the defaults on both ends, and so do
+    // headless ones
+    if (state->input.mode == INPUT_MODE_LIVE && !state->headless.enabled) {
+        snapshot_init();
     }
+    fft_init(&state->fft);
 
-    state->font = LoadFontEx("DejaVuSans.ttf", 200, all_chars, totalCount);
-    state->font_spacing = 2;
-
-    state->chord_idx = 0;
+    load_font();
 
+    if (state->input.mode == INPUT_MODE_REPLAY || state->headless.enabled) {
+        return;
+    }
     InitAudioDevice();
-    SetAudioStreamBufferSizeDefault(4096);
-    state->audio_stream = LoadAudioStream(44100, 16, 1);
+    SetAudioStreamBufferSizeDefault(AUDIO_BUFFER_FRAMES);
+    state->audio_stream = LoadAudioStream(SAMPLE_RATE, 16, 1);
     SetAudioStreamCallback(state->audio_stream, chord_synthesizer);
     PlayAudioStream(state->audio_stream);
 }
 
 void update() {
-    state->mouse_position = GetMousePosition();
-
-    // TODO: volume fade is not really doing anything relevant
-    // was it not supposed to fade on start and stop?
-    if (state->volume_fade < 1.0f) {
-        state->volume_fade += GetFrameTime() * 10.0f;
-        if (state->volume_fade > 1.0f) {
-            state->volume_fade = 1.0f;
-        }
+    profile_begin_frame();
+    profile_begin(PROFILE_SECTION_UPDATE);
+
+    input_begin_frame();
+    if (input_window_resized()) {
+        refresh_layout(input_screen_width(), input_screen_height());
+    }
+
+    state->mouse_position = input_mouse_position();
+
+    if (input_key_pressed(KEY_F2)) {
+        toggle_flag(FLAG_OSCILLOSCOPE);
+    }
+    if (input_key_pressed(KEY_F5)) {
+        toggle_flag(FLAG_SPECTRUM);
+    }
+    if (input_key_pressed(KEY_F3)) {
+        toggle_flag(FLAG_PROFILER);
+    }
+    if (input_key_pressed(KEY_F4)) {
+        export_profile_trace(PROFILE_TRACE_FILE);
+    }
+    if (input_key_pressed(KEY_F6)) {
+        state->engine.use_pcm_cache = !state->engine.use_pcm_cache;
+    }
+    if (input_key_pressed(KEY_F7)) {
+        start_batch_export();
+    }
+    if (input_key_pressed(KEY_F8)) {
+        toggle_recording(RECORDING_FORMAT_FLAC);
     }
+    if (input_key_pressed(KEY_F9)) {
+        toggle_recording(RECORDING_FORMAT_WAV);
+    }
+    if (input_key_pressed(KEY_F10)) {
+        export_midi(input_shift_down());
+    }
+    if (input_key_pressed(KEY_F11)) {
+        cycle_midi_out_mode();
+    }
+    if (input_key_pressed(KEY_F12)) {
+        toggle_midi_in();
+    }
+    midi_in_update();
 
     switch (state->state) {
         case STATE_MAIN: {
-            if (!IsMouseButtonPressed(0)) {
+            if (!input_mouse_pressed(0)) {
                 break;
             }
 
             if (mouse_in_rectangle(get_load_file_rectangle())) {
+                state->state = STATE_LOAD_FILE;
+                state->cmd_cursor = 0;
+                state->cmd_buffer[0] = '\0';
             } else if (mouse_in_rectangle(get_save_file_rectangle())) {
                 state->state = STATE_SAVE_FILE;
                 state->cmd_cursor = 0;
                 state->cmd_buffer[0] = '\0';
             } else if (mouse_in_rectangle(get_sequencer_state_section_rectangle())) {
-                for (int i = 0; i < SEQUENCER_AMOUNT; i++) {
-                    if (mouse_in_rectangle(get_sequencer_state_rectangle(i))) {
-                        Rectangle rec = get_sequencer_state_rectangle(i);
-                        if (mouse_in_rectangle(get_sequencer_section_rectangle(rec, SEQUENCER_STATE_SECTION_RESET))) {
-                            sequencer_reset_section(i);
-                        } else if (mouse_in_rectangle(get_sequencer_section_rectangle(rec, SEQUENCER_STATE_SECTION_ENABLE))) {
-                            state->sequencer_states[i] = !state->sequencer_states[i];
-                        }
-                        break;
-                    }
+                int section;
+                int idx = get_sequencer_state_at(state->mouse_position, &section);
+                if (idx >= 0 && section == SEQUENCER_STATE_SECTION_RESET) {
+                    sequencer_reset_section(&state->engine, idx);
+                } else if (idx >= 0 && section == SEQUENCER_STATE_SECTION_ENABLE) {
+                    state->engine.sequencer_states[idx] = !state->engine.sequencer_states[idx];
                 }
             } else if (mouse_in_rectangle(get_sequencer_rectangle())) {
-                for (int i = 0; i < SEQUENCER_ELEMENTS; i++) {
-                    if (mouse_in_rectangle(get_sequencer_element_rectangle(i))) {
-                        Rectangle rec = get_sequencer_element_rectangle(i);
-                        if (mouse_in_rectangle(get_sequencer_section_rectangle(rec, SEQUENCER_ELEMENT_SECTION_BUTTON))) {
-                            prepare_select_state(SELECTABLE_TYPE_SCALE_DEGREE, state->mouse_position, &(state->sequencer[i]));
-                        } else if (mouse_in_rectangle(get_sequencer_section_rectangle(rec, SEQUENCER_ELEMENT_SECTION_CURSOR))) {
-                            state->chord_idx = i;
-                            state->chord_timer = 0.0f;
-                            if (state->sequencer[i] == SCALE_DEGREE_NONE) {
-                                progress();
-                            }
-                        }
-                        break;
+                int section;
+                int idx = get_sequencer_element_at(state->mouse_position, &section);
+                if (idx >= 0 && section == SEQUENCER_ELEMENT_SECTION_BUTTON) {
+                    prepare_select_state(SELECTABLE_TYPE_SCALE_DEGREE, state->mouse_position, &(state->engine.sequencer[idx]));
+                } else if (idx >= 0 && section == SEQUENCER_ELEMENT_SECTION_CURSOR) {
+                    state->engine.chord_idx = idx;
+                    state->engine.chord_timer = 0.0f;
+                    if (state->engine.sequencer[idx] == SCALE_DEGREE_NONE) {
+                        progress(&state->engine);
                     }
                 }
             } else if (mouse_in_rectangle(get_play_button_rectangle())) {
-                toggle_flag(FLAG_PLAYING);
-                if (has_flag(FLAG_PLAYING)) {
-                    if (state->sequencer[state->chord_idx] == SCALE_DEGREE_NONE) {
-                        progress();
+                state->engine.playing = !state->engine.playing;
+                if (state->engine.playing) {
+                    if (state->engine.sequencer[state->engine.chord_idx] == SCALE_DEGREE_NONE) {
+                        progress(&state->engine);
                     }
                 } else {
-                    state->chord_timer = 0.0f;
+                    state->engine.chord_timer = 0.0f;
+                    rt_check_report();
                 }
             } else if (mouse_in_rectangle(get_control_rectangle(CONTROLS_SCALE))) {
-                prepare_select_state(SELECTABLE_TYPE_SCALE_TYPE, state->mouse_position, &(state->scale_root));
+                prepare_select_state(SELECTABLE_TYPE_SCALE_TYPE, state->mouse_position, &(state->engine.scale_root));
             } else if (mouse_in_rectangle(get_control_rectangle(CONTROLS_ROOT_NOTE))) {
-                prepare_select_state(SELECTABLE_TYPE_SCALE_ROOT, state->mouse_position, &(state->scale_root));
+                prepare_select_state(SELECTABLE_TYPE_SCALE_ROOT, state->mouse_position, &(state->engine.scale_root));
             } else if (mouse_in_rectangle(get_control_rectangle(CONTROLS_VIBE))) {
-                prepare_select_state(SELECTABLE_TYPE_VIBE, state->mouse_position, &(state->vibe));
+                prepare_select_state(SELECTABLE_TYPE_VIBE, state->mouse_position, &(state->engine.vibe));
             } else if (mouse_in_rectangle(get_control_rectangle(CONTROLS_VIBES_PER_CHORD))) {
-                prepare_select_state(SELECTABLE_TYPE_VIBES_PER_CHORD, state->mouse_position, &(state->vibes_per_chord));
+                prepare_select_state(SELECTABLE_TYPE_VIBES_PER_CHORD, state->mouse_position, &(state->engine.vibes_per_chord));
             } else if (mouse_in_rectangle(get_control_rectangle(CONTROLS_ACCIDENTAL))) {
-                toggle_flag(FLAG_FLATS);
+                state->engine.flats = !state->engine.flats;
             } else if (mouse_in_rectangle(get_control_value_rectangle(CONTROLS_VOLUME))) {
                 Rectangle rec = get_control_value_rectangle(CONTROLS_VOLUME);
-                state->volume_manual = (state->mouse_position.x - rec.x) / rec.width;
+                state->engine.volume_manual = (state->mouse_position.x - rec.x) / rec.width;
             } else if (mouse_in_rectangle(get_control_value_rectangle(CONTROLS_INTERVAL))) {
                 Rectangle rec = get_control_value_rectangle(CONTROLS_INTERVAL);
-                float offset = state->min_time_per_chord;
+                float offset = state->engine.min_time_per_chord;
                 float offset_mouse = (state->mouse_position.x - rec.x - offset) / rec.width;
-                state->time_per_chord = offset + (offset_mouse * get_time_per_chord_range());
+                state->engine.time_per_chord = offset + (offset_mouse * get_time_per_chord_range(&state->engine));
             }
         } break;
         case STATE_SELECT: {
-            if (!IsMouseButtonPressed(0)) {
+            if (!input_mouse_pressed(0)) {
                 break;
             }
 
@@ -153,25 +167,25 @@ void update() {
                         *(state->selectables.reference) = item_idx;
                     } break;
                     case SELECTABLE_TYPE_SCALE_TYPE: {
-                        state->scale_type = item_idx;
-                        refresh_scale();
+                        state->engine.scale_type = item_idx;
+                        refresh_scale(&state->engine);
                     } break;
                     case SELECTABLE_TYPE_VIBES_PER_CHORD: {
-                        float prev_vibes_per_chord = (float)state->vibes_per_chord;
-                        state->vibes_per_chord = pow(2, item_idx);
-                        refresh_time_per_chord_range();
-                        float multiplier = state->vibes_per_chord / prev_vibes_per_chord;
-                        float new_time_per_chord = state->time_per_chord * multiplier;
-                        set_time_per_chord(new_time_per_chord);
+                        float prev_vibes_per_chord = (float)state->engine.vibes_per_chord;
+                        state->engine.vibes_per_chord = pow(2, item_idx);
+                        refresh_time_per_chord_range(&state->engine);
+                        float multiplier = state->engine.vibes_per_chord / prev_vibes_per_chord;
+                        float new_time_per_chord = state->engine.time_per_chord * multiplier;
+                        set_time_per_chord(&state->engine, new_time_per_chord);
                     } break;
                     case SELECTABLE_TYPE_VIBE: {
-                        float old_range = get_time_per_chord_range();
-                        float old_location = (state->time_per_chord - state->min_time_per_chord) / old_range;
-                        state->vibe = item_idx;
-                        refresh_time_per_chord_range();
-                        float new_range = get_time_per_chord_range();
-                        float new_time_per_chord = state->min_time_per_chord + old_location * new_range;
-                        set_time_per_chord(new_time_per_chord);
+                        float old_range = get_time_per_chord_range(&state->engine);
+                        float old_location = (state->engine.time_per_chord - state->engine.min_time_per_chord) / old_range;
+                        state->engine.vibe = item_idx;
+                        refresh_time_per_chord_range(&state->engine);
+                        float new_range = get_time_per_chord_range(&state->engine);
+                        float new_time_per_chord = state->engine.min_time_per_chord + old_location * new_range;
+                        set_time_per_chord(&state->engine, new_time_per_chord);
                     } break;
                 }
             }
@@ -183,27 +197,101 @@ void update() {
                 state->state = STATE_MAIN;
             }
         } break;
+        case STATE_LOAD_FILE: {
+            if (cmd_enter_file_name()) {
+                const char *file_name = TextFormat("%s.mid", state->cmd_buffer);
+                uint8 result = import_midi(file_name);
+                state->state = STATE_MAIN;
+                if (result != MIDI_IMPORT_OK) {
+                    cmd_show_message(TextFormat("could not load \"%s\": %s", file_name, get_midi_import_result_name(result)));
+                }
+            }
+        } break;
+        case STATE_RESTORE: {
+            if (input_key_pressed(KEY_Y) || input_key_pressed(KEY_ENTER)) {
+                snapshot_restore();
+                state->state = STATE_MAIN;
+            } else if (input_key_pressed(KEY_N)) {
+                state->state = STATE_MAIN;
+            }
+        } break;
+        case STATE_MESSAGE: {
+            if (input_key_pressed(KEY_ENTER) || input_mouse_pressed(0)) {
+                state->state = STATE_MAIN;
+            }
+        } break;
+    }
+
+    if (IsFileDropped()) {
+        FilePathList files = LoadDroppedFiles();
+        // the first one that imports, or what went wrong with the last one
+        char failure[CMD_MAX_MESSAGE] = "";
+        for (unsigned int i = 0; i < files.count; i++) {
+            if (!IsFileExtension(files.paths[i], ".mid;.midi")) {
+                continue;
+            }
+            uint8 result = import_midi(files.paths[i]);
+            if (result == MIDI_IMPORT_OK) {
+                failure[0] = '\0';
+                break;
+            }
+            snprintf(failure, CMD_MAX_MESSAGE, "could not load \"%s\": %s", GetFileName(files.paths[i]), get_midi_import_result_name(result));
+        }
+        if (failure[0] != '\0') {
+            cmd_show_message(failure);
+        }
+        UnloadDroppedFiles(files);
+    }
+
+    publish_param_targets(&state->engine);
+    pcm_cache_request(&state->engine);
+    snapshot_update();
+
+    // a replay has no audio device, the engine moves on exactly one frame
+    if (state->input.mode == INPUT_MODE_REPLAY) {
+        int16 block[INPUT_REPLAY_AUDIO_FRAMES];
+        chord_synthesizer(block, INPUT_REPLAY_AUDIO_FRAMES);
+    }
+
+    profile_end(PROFILE_SECTION_UPDATE);
+}
+
+// the rest of the frame is waited out after the swap, outside of any
+// section, so the profiler shows it as the gap it is
+static void wait_for_frame() {
+    double remaining = get_profile_frame(0)->start + state->frame_time - GetTime();
+    if (remaining > 0.0) {
+        WaitTime(remaining);
     }
 }
 
 void render() {
     BeginDrawing();
-    ClearBackground(TP_BG);
-    draw_load_file_button();
-    draw_save_file_button();
-    draw_sequencer();
-    draw_play_control();
-    draw_controls();
-    draw_cmd();
-    if (state->state == STATE_SELECT) {
-        draw_selectables();
-    }
+    draw_frame();
+
+    profile_begin(PROFILE_SECTION_END_DRAWING);
     EndDrawing();
+    profile_end(PROFILE_SECTION_END_DRAWING);
+
+    wait_for_frame();
 }
 
 void cleanup() {
-    UnloadAudioStream(state->audio_stream);
-    CloseAudioDevice();
+    input_finish();
+    if (IsAudioDeviceReady()) {
+        UnloadAudioStream(state->audio_stream);
+        CloseAudioDevice();
+    }
+    rt_check_report();
+    stop_recording();
+    stop_midi_out();
+    stop_midi_in();
+    engine_destroy(&state->engine);
+    finish_batch_export();
+    snapshot_finish();
+    unload_font();
+    draw_batch_unload();
     free(state);
     CloseWindow();
+    log_stop();
 }
@@ -0,0 +1,13 @@
+#include "engine.h"
+#include "debug.h"
+
+// the engine library, built on its own so it can be linked into the app,
+// the benchmarks and the tests without a window
+
+#include "log.c"
+#include "filter.c"
+#include "smooth.c"
+#include "music.c"
+#include "synth.c"
+#include "pcm_cache.c"
+#include "transport.c"
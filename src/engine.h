@@ -0,0 +1,424 @@
+#ifndef ENGINE_H
+#define ENGINE_H
+
+#include <math.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdatomic.h>
+#include <pthread.h>
+
+// the theory, sequencer, transport and synth. nothing in here knows about
+// raylib or the window, it all works on an Engine passed in by the caller
+
+#ifndef PI
+    #define PI 3.14159265358979323846f
+#endif
+
+#define VIBES_PER_CHORD_MIN 1
+#define VIBES_PER_CHORD_MAX 16
+
+#define INTERVAL_MAJOR_THIRD 4
+#define INTERVAL_MINOR_THIRD 3
+#define INTERVAL_FIFTH 7
+#define INTERVAL_FLAT_FIFTH 6
+#define INTERVAL_AUGMENTED_FIFTH 8
+
+#define SCALE_MAJOR             ((Scale){0, 2, 4, 5, 7, 9, 11})
+#define SCALE_DORIAN            ((Scale){0, 2, 3, 5, 7, 9, 10})
+#define SCALE_PHRYGIAN          ((Scale){0, 1, 3, 5, 7, 8, 10})
+#define SCALE_LYDIAN            ((Scale){0, 2, 4, 6, 7, 9, 11})
+#define SCALE_MIXOLYDIAN        ((Scale){0, 2, 4, 5, 7, 9, 10})
+#define SCALE_MINOR             ((Scale){0, 2, 3, 5, 7, 8, 10})
+#define SCALE_LOCRIAN           ((Scale){0, 1, 3, 5, 6, 8, 10})
+#define SCALE_HARMONIC_MINOR    ((Scale){0, 2, 3, 5, 7, 8, 11})
+#define SCALE_MELODIC_MINOR     ((Scale){0, 2, 3, 5, 7, 9, 11})
+typedef int8_t int8;
+typedef uint8_t uint8;
+typedef int16_t int16;
+typedef uint16_t uint16;
+typedef int32_t int32;
+typedef uint32_t uint32;
+typedef int64_t int64;
+typedef uint64_t uint64;
+#define SCALE_DEGREE_COUNT 7
+typedef uint8 Scale[SCALE_DEGREE_COUNT];
+
+#define SEQUENCER_AMOUNT 4
+#define SEQUENCER_ROW 8
+#define SEQUENCER_ELEMENTS (SEQUENCER_AMOUNT * SEQUENCER_ROW)
+typedef uint8 Sequencers[SEQUENCER_ELEMENTS];
+
+// root, third, fifth and the fifth an octave down
+#define FREQ_COUNT 4
+
+#define CHORD_NAME_CAPACITY 16
+typedef struct Chord {
+    uint8 root;
+    uint8 third;
+    uint8 fifth;
+    uint8 type;
+    char symbol[CHORD_NAME_CAPACITY];
+    char roman[CHORD_NAME_CAPACITY];
+} Chord;
+enum {
+    SCALE_DEGREE_I,
+    SCALE_DEGREE_II,
+    SCALE_DEGREE_III,
+    SCALE_DEGREE_IV,
+    SCALE_DEGREE_V,
+    SCALE_DEGREE_VI,
+    SCALE_DEGREE_VII,
+    SCALE_DEGREE_NONE,
+};
+
+enum {
+    NOTE_A,
+    NOTE_A_SHARP,
+    NOTE_B_FLAT = NOTE_A_SHARP,
+    NOTE_B,
+    NOTE_C,
+    NOTE_C_SHARP,
+    NOTE_D_FLAT = NOTE_C_SHARP,
+    NOTE_D,
+    NOTE_D_SHARP,
+    NOTE_E_FLAT = NOTE_D_SHARP,
+    NOTE_E,
+    NOTE_F,
+    NOTE_F_SHARP,
+    NOTE_G_FLAT = NOTE_F_SHARP,
+    NOTE_G,
+    NOTE_G_SHARP,
+    NOTE_A_FLAT = NOTE_G_SHARP,
+    NOTE_COUNT,
+};
+
+enum {
+    CHORD_TYPE_NONE,
+    CHORD_TYPE_MAJOR,
+    CHORD_TYPE_MINOR,
+    CHORD_TYPE_DIMINISHED,
+    CHORD_TYPE_AUGMENTED,
+};
+
+enum {
+    SCALE_TYPE_MAJOR,
+    SCALE_TYPE_DORIAN,
+    SCALE_TYPE_PHRYGIAN,
+    SCALE_TYPE_LYDIAN,
+    SCALE_TYPE_MIXOLYDIAN,
+    SCALE_TYPE_MINOR,
+    SCALE_TYPE_LOCRIAN,
+    SCALE_TYPE_HARMONIC_MINOR,
+    SCALE_TYPE_MELODIC_MINOR,
+    SCALE_TYPE_COUNT,
+};
+
+enum {
+    VIBE_POLKA,
+    VIBE_SWING,
+    VIBE_WALTZ,
+    VIBE_CHORD,
+    VIBE_ROOT,
+    VIBE_THIRD,
+    VIBE_FIFTH,
+    VIBE_COUNT,
+};
+
+#define MIN_TIME_PER_CHORD_DEFAULT 0.5f
+#define MAX_TIME_PER_CHORD_DEFAULT 2.0f
+
+#define FILTER_CUTOFF_DEFAULT 2000.0f
+#define FILTER_RESONANCE_DEFAULT 0.2f
+#define FILTER_KEY_TRACKING_DEFAULT 0.5f
+
+// midi note of A4, note_to_freq(NOTE_A, 4) is 440hz
+#define MIDI_NOTE_A4 69
+
+enum {
+    PARAM_VOLUME,
+    PARAM_FADE,
+    PARAM_CUTOFF,
+    PARAM_TEMPO,
+    PARAM_COUNT,
+};
+
+#define SAMPLE_RATE 44100
+
+// everything that decides how one bar of a chord sounds
+typedef struct SynthParams {
+    uint8 root;
+    uint8 third;
+    uint8 fifth;
+    uint8 vibe;
+    uint8 vibes_per_chord;
+    float time_per_chord;
+    float cutoff;
+    float resonance;
+    float key_tracking;
+} SynthParams;
+
+#define PCM_CACHE_ENTRY_COUNT 32
+#define PCM_CACHE_BUDGET (32 * 1024 * 1024)
+
+enum {
+    PCM_CACHE_ENTRY_EMPTY,
+    PCM_CACHE_ENTRY_READY,
+    PCM_CACHE_ENTRY_EVICTING,
+};
+
+typedef struct PcmCacheEntry {
+    _Atomic int status;
+    _Atomic int pins;
+    _Atomic uint64 last_used;
+    SynthParams params;
+    int16 *samples;
+    uint32 frame_count;
+} PcmCacheEntry;
+
+// entries are filled and evicted by the worker thread only, the audio
+// callback pins the one it reads so it can never be freed under it
+typedef struct PcmCache {
+    PcmCacheEntry entries[PCM_CACHE_ENTRY_COUNT];
+    _Atomic uint64 clock;
+    _Atomic uint32 bytes;
+    _Atomic int ready_count;
+    pthread_t thread;
+    // guards the wanted list and quit, the audio callback never takes it
+    pthread_mutex_t mutex;
+    pthread_cond_t wake;
+    SynthParams wanted[SEQUENCER_ELEMENTS];
+    int wanted_count;
+    bool dirty;
+    bool quit;
+    // what the ui asked for last, only touched by the ui thread
+    SynthParams requested[SEQUENCER_ELEMENTS];
+    int requested_count;
+} PcmCache;
+
+typedef struct FilterBank {
+    _Alignas(16) float ic1eq[FREQ_COUNT];
+    _Alignas(16) float ic2eq[FREQ_COUNT];
+    _Alignas(16) float a1[FREQ_COUNT];
+    _Alignas(16) float a2[FREQ_COUNT];
+    _Alignas(16) float a3[FREQ_COUNT];
+    float g[FREQ_COUNT];
+    float k;
+    bool primed;
+} FilterBank;
+
+typedef struct Smoother {
+    float value;
+    float target;
+    float step;
+    float increment;
+    float end;
+    bool primed;
+} Smoother;
+
+typedef enum ChordBits {
+    BIT_NONE = 0,
+    BIT_1 = 1 << 0,
+    BIT_3 = 1 << 1,
+    BIT_5 = 1 << 2,
+    BIT_5_LOW = 1 << 3,
+    BIT_ALL = ~0,
+} ChordBits;
+
+enum {
+    ENVELOPE_CURVE_LINEAR,
+    ENVELOPE_CURVE_EXPONENTIAL,
+};
+
+// times are in seconds, sustain is a level
+typedef struct Envelope {
+    float attack;
+    float decay;
+    float sustain;
+    float release;
+    uint8 curve;
+} Envelope;
+
+typedef struct EnvelopeVoice {
+    uint8 segment;
+    uint8 curve;
+    uint32 samples_left;
+    float level;
+    float target;
+    float mul;
+    float add;
+    float sustain;
+    float gain;
+    uint32 decay_samples;
+    uint32 sustain_samples;
+    uint32 release_samples;
+} EnvelopeVoice;
+
+typedef struct VibeStep {
+    float start;
+    float end;
+    ChordBits bits;
+    Envelope envelope;
+} VibeStep;
+
+// offline renders go in chunks of this size so the filter coefficients
+// ease in the same way every time
+#define SYNTH_RENDER_CHUNK 1024
+
+// everything a running synth remembers between blocks. the transport
+// has one, the pcm cache worker and the exporters render with their own
+typedef struct Synth {
+    FilterBank filter;
+    EnvelopeVoice voices[FREQ_COUNT];
+    float phase[FREQ_COUNT];
+    float lfo_phase;
+    int prev_step;
+    float prev_local_time;
+} Synth;
+
+// called by the transport on the audio thread for every piece of a chord it
+// plays, count frames from position into the chord. frame is where the piece
+// starts counted from the first block ever rendered
+typedef void (*EngineChordCallback)(void *data, const SynthParams *params, uint32 position, uint32 count, uint64 frame);
+
+// what the app used to keep in its global state for the music side of things.
+// the ui thread edits the settings, the audio thread runs the transport
+typedef struct Engine {
+    uint8 scale_type;
+    uint8 scale_root;
+    uint8 vibe;
+    uint8 vibes_per_chord;
+    bool flats;
+    bool playing;
+    bool use_pcm_cache;
+    float time_per_chord;
+    float min_time_per_chord;
+    float max_time_per_chord;
+    float chord_timer;
+    Scale scale;
+    Sequencers sequencer;
+    bool sequencer_states[SEQUENCER_AMOUNT];
+    int chord_idx;
+    float volume_manual;
+    float filter_cutoff;
+    float filter_resonance;
+    float filter_key_tracking;
+    _Atomic float param_targets[PARAM_COUNT];
+    PcmCache pcm_cache;
+    bool pcm_cache_started;
+    // only touched by the audio thread
+    Synth synth;
+    Smoother smoothers[PARAM_COUNT];
+    uint64 frame;
+    bool mute;
+    EngineChordCallback chord_callback;
+    void *chord_callback_data;
+} Engine;
+
+#define LOG_RING_CAPACITY 1024
+#define LOG_RING_MASK (LOG_RING_CAPACITY - 1)
+#define LOG_ARG_COUNT 4
+
+enum {
+    LOG_LEVEL_INFO,
+    LOG_LEVEL_WARNING,
+    LOG_LEVEL_ERROR,
+    LOG_LEVEL_FATAL,
+};
+
+// every message the program can log, the text for each is in log.c
+enum {
+    LOG_CODE_ASSERT,
+    LOG_CODE_RECORDER_DROPPED,
+    LOG_CODE_COUNT,
+};
+
+// sequence says whose turn the slot is, see log.c
+typedef struct LogRecord {
+    _Atomic uint32 sequence;
+    uint8 level;
+    uint16 code;
+    int line;
+    uint64 time_ns;
+    // string literals only, asserts put the condition and file here
+    const char *text;
+    const char *file;
+    double args[LOG_ARG_COUNT];
+} LogRecord;
+
+// any thread writes records, the log thread formats them.
+// multiple producers, single consumer
+typedef struct Log {
+    LogRecord ring[LOG_RING_CAPACITY];
+    _Atomic uint32 write_idx;
+    uint32 read_idx;
+    _Atomic uint32 dropped;
+    _Atomic uint32 soft_assert_count;
+    _Atomic bool fatal;
+    _Atomic bool running;
+    pthread_t thread;
+    bool started;
+    uint64 start_ns;
+} Log;
+
+#define LOG(level, code, ...) log_write(level, code, (double[LOG_ARG_COUNT]){ __VA_ARGS__ })
+
+// log.c
+void log_write(uint8 level, uint16 code, const double *args);
+void log_assert(const char *condition, const char *file, int line, bool fatal);
+uint32 get_soft_assert_count();
+void log_start();
+void log_stop();
+
+// filter.c
+void flush_denormals();
+void filter_bank_update(FilterBank *bank, const float *freq, float cutoff, float resonance, float key_tracking, float sample_rate);
+void filter_bank_flush_denormals(FilterBank *bank);
+
+// smooth.c
+void publish_param_targets(Engine *engine);
+void smoother_begin_block(Smoother *smoother, float target, float ramp_time, uint32 frames, float sample_rate);
+void smoother_end_block(Smoother *smoother);
+
+// music.c
+float note_to_freq(uint8 note, int octave);
+int truncate_note_accidentals(int note, bool flats);
+void get_scale(uint8 scale_type, uint8 *scale);
+void refresh_scale(Engine *engine);
+float get_time_per_chord_range(const Engine *engine);
+void refresh_time_per_chord_range(Engine *engine);
+float get_centralized_time_per_chord(const Engine *engine);
+void set_time_per_chord(Engine *engine, float value);
+bool is_sequencer_active(const Engine *engine);
+Chord make_chord(const uint8 *scale, uint8 scale_root, int degree);
+Chord get_sequencer_chord(const Engine *engine, int degree);
+void sequencer_reset_section(Engine *engine, int idx);
+void progress(Engine *engine);
+int get_vibe_steps(uint8 vibe, float time_per_chord, uint8 vibes_per_chord, VibeStep *steps, float *fract);
+void get_chord_voicing(uint8 root, uint8 third, uint8 fifth, uint8 vibe, int *notes);
+void get_chord_freqs(uint8 root, uint8 third, uint8 fifth, uint8 vibe, float *freq);
+
+// synth.c
+void synth_reset(Synth *synth);
+bool synth_params_equal(const SynthParams *a, const SynthParams *b);
+uint32 get_chord_frame_count(float time_per_chord);
+void synth_render(Synth *synth, const SynthParams *params, float chord_time, bool releasing, int16 *out, uint32 frames);
+void synth_apply_gain(int16 *samples, uint32 frames, Smoother *volume, Smoother *fade);
+
+// pcm_cache.c
+void pcm_cache_init(PcmCache *cache);
+void pcm_cache_destroy(PcmCache *cache);
+bool pcm_cache_read(PcmCache *cache, const SynthParams *params, uint32 offset, int16 *out, uint32 count);
+SynthParams get_synth_params(const Engine *engine, Chord chord, float time_per_chord, float cutoff);
+void pcm_cache_request(Engine *engine);
+
+// transport.c
+void engine_init(Engine *engine);
+void engine_reset(Engine *engine);
+void engine_destroy(Engine *engine);
+void engine_start_pcm_cache(Engine *engine);
+bool engine_render(Engine *engine, int16 *out, uint32 frames);
+
+#endif
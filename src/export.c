@@ -0,0 +1,225 @@
+#include <time.h>
+#ifndef _WIN32
+    #include <unistd.h>
+#endif
+
+// renders the progression once in every root and scale type to its own wav.
+// the jobs are handed out to one worker per processor, each with its own synth
+
+#define EXPORT_MAX_WORKERS 64
+// how long the last chord gets to ring out after the progression ends
+#define EXPORT_TAIL_TIME 0.5f
+#define EXPORT_FILE_NAME_CAPACITY 64
+
+static double get_wall_time() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static int get_processor_count() {
+#ifdef _WIN32
+    int count = pthread_num_processors_np();
+#else
+    int count = sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+    if (count < 1) {
+        count = 1;
+    }
+    return (count < EXPORT_MAX_WORKERS) ? count : EXPORT_MAX_WORKERS;
+}
+
+static SynthParams get_export_synth_params(const ExportSettings *settings, Chord chord) {
+    return (SynthParams){
+        .root = chord.root,
+        .third = chord.third,
+        .fifth = chord.fifth,
+        .vibe = settings->vibe,
+        .vibes_per_chord = settings->vibes_per_chord,
+        .time_per_chord = settings->time_per_chord,
+        .cutoff = settings->cutoff,
+        .resonance = settings->resonance,
+        .key_tracking = settings->key_tracking,
+    };
+}
+
+void get_export_settings(ExportSettings *settings) {
+    memcpy(settings->sequencer, state->engine.sequencer, sizeof(Sequencers));
+    memcpy(settings->sequencer_states, state->engine.sequencer_states, sizeof(settings->sequencer_states));
+    settings->vibe = state->engine.vibe;
+    settings->vibes_per_chord = state->engine.vibes_per_chord;
+    settings->time_per_chord = state->engine.time_per_chord;
+    settings->cutoff = state->engine.filter_cutoff;
+    settings->resonance = state->engine.filter_resonance;
+    settings->key_tracking = state->engine.filter_key_tracking;
+}
+
+static bool export_job(const ExportSettings *settings, Synth *synth, WavWriter *writer, int job, const char *file_name, uint32 *frame_count) {
+    uint8 scale_root = job % NOTE_COUNT;
+    Scale scale;
+    get_scale(job / NOTE_COUNT, scale);
+
+    *frame_count = 0;
+    if (!wav_writer_open(writer, file_name, SAMPLE_RATE, 1)) {
+        return false;
+    }
+
+    synth_reset(synth);
+    int16 chunk[SYNTH_RENDER_CHUNK];
+    SynthParams params = {0};
+    bool any = false;
+
+    for (int i = 0; i < SEQUENCER_ELEMENTS; i++) {
+        if (!settings->sequencer_states[i / SEQUENCER_ROW]) {
+            continue;
+        }
+        Chord chord = make_chord(scale, scale_root, settings->sequencer[i]);
+        if (chord.type == CHORD_TYPE_NONE) {
+            continue;
+        }
+
+        params = get_export_synth_params(settings, chord);
+        any = true;
+
+        uint32 bar_frame_count = get_chord_frame_count(params.time_per_chord);
+        for (uint32 j = 0; j < bar_frame_count; j += SYNTH_RENDER_CHUNK) {
+            uint32 count = (bar_frame_count - j < SYNTH_RENDER_CHUNK) ? bar_frame_count - j : SYNTH_RENDER_CHUNK;
+            synth_render(synth, &params, j / (float)SAMPLE_RATE, false, chunk, count);
+            wav_writer_write(writer, chunk, count);
+            *frame_count += count;
+        }
+    }
+
+    if (any) {
+        uint32 tail_frame_count = EXPORT_TAIL_TIME * SAMPLE_RATE;
+        for (uint32 j = 0; j < tail_frame_count; j += SYNTH_RENDER_CHUNK) {
+            uint32 count = (tail_frame_count - j < SYNTH_RENDER_CHUNK) ? tail_frame_count - j : SYNTH_RENDER_CHUNK;
+            synth_render(synth, &params, 0.0f, true, chunk, count);
+            wav_writer_write(writer, chunk, count);
+            *frame_count += count;
+        }
+    }
+
+    return wav_writer_close(writer);
+}
+
+static void *export_worker(void *arg) {
+    Exporter *exporter = (Exporter *)arg;
+    Synth *synth = (Synth *)malloc(sizeof(Synth));
+    WavWriter *writer = (WavWriter *)malloc(sizeof(WavWriter));
+
+    flush_denormals();
+
+    while (synth != NULL && writer != NULL) {
+        int job = atomic_fetch_add(&exporter->next_job, 1);
+        if (job >= EXPORT_JOB_COUNT) {
+            break;
+        }
+
+        char file_name[EXPORT_FILE_NAME_CAPACITY];
+        snprintf(
+            file_name,
+            EXPORT_FILE_NAME_CAPACITY,
+            "%s/%s_%s.wav",
+            EXPORT_DIRECTORY,
+            get_note_file_name(job % NOTE_COUNT),
+            get_scale_file_name(job / NOTE_COUNT)
+        );
+
+        double start = get_wall_time();
+        uint32 frame_count;
+        bool ok = export_job(&exporter->settings, synth, writer, job, file_name, &frame_count);
+        double elapsed = get_wall_time() - start;
+
+        if (!ok) {
+            printf("export: could not write %s\n", file_name);
+            atomic_fetch_add(&exporter->failed_count, 1);
+        } else {
+            double seconds = (double)frame_count / SAMPLE_RATE;
+            printf(
+                "export: %s, %.1fs of audio in %.1fms (%.0fx realtime)\n",
+                file_name,
+                seconds,
+                elapsed * 1000.0,
+                (elapsed > 0.0) ? seconds / elapsed : 0.0
+            );
+        }
+        atomic_fetch_add(&exporter->frame_count, frame_count);
+        atomic_fetch_add(&exporter->done_count, 1);
+    }
+
+    free(writer);
+    free(synth);
+    return NULL;
+}
+
+static void *export_run(void *arg) {
+    Exporter *exporter = (Exporter *)arg;
+    int worker_count = get_processor_count();
+    pthread_t workers[EXPORT_MAX_WORKERS];
+
+    double start = get_wall_time();
+
+    int started = 0;
+    for (int i = 0; i < worker_count; i++) {
+        if (pthread_create(&workers[started], NULL, export_worker, exporter) == 0) {
+            started++;
+        }
+    }
+    // no threads to be had, do it all on this one
+    if (started == 0) {
+        export_worker(exporter);
+    }
+    for (int i = 0; i < started; i++) {
+        pthread_join(workers[i], NULL);
+    }
+
+    double elapsed = get_wall_time() - start;
+    double seconds = (double)atomic_load(&exporter->frame_count) / SAMPLE_RATE;
+    printf(
+        "export: %d files (%d failed) on %d workers, %.1fs of audio in %.2fs (%.0fx realtime)\n",
+        atomic_load(&exporter->done_count),
+        atomic_load(&exporter->failed_count),
+        started,
+        seconds,
+        elapsed,
+        (elapsed > 0.0) ? seconds / elapsed : 0.0
+    );
+
+    atomic_store(&exporter->running, false);
+    return NULL;
+}
+
+void start_batch_export() {
+    Exporter *exporter = &state->exporter;
+    if (atomic_load(&exporter->running) || !is_sequencer_active(&state->engine)) {
+        return;
+    }
+    if (exporter->started) {
+        pthread_join(exporter->thread, NULL);
+        exporter->started = false;
+    }
+
+    MakeDirectory(EXPORT_DIRECTORY);
+    get_export_settings(&exporter->settings);
+
+    atomic_store(&exporter->next_job, 0);
+    atomic_store(&exporter->done_count, 0);
+    atomic_store(&exporter->failed_count, 0);
+    atomic_store(&exporter->frame_count, 0);
+    atomic_store(&exporter->running, true);
+
+    if (pthread_create(&exporter->thread, NULL, export_run, exporter) == 0) {
+        exporter->started = true;
+    } else {
+        atomic_store(&exporter->running, false);
+    }
+}
+
+void finish_batch_export() {
+    Exporter *exporter = &state->exporter;
+    if (exporter->started) {
+        pthread_join(exporter->thread, NULL);
+        exporter->started = false;
+    }
+}
@@ -0,0 +1,145 @@
+#ifdef __SSE__
+    #include <xmmintrin.h>
+#endif
+
+// real fft of FFT_SIZE points done as a complex fft of half the size
+// (even samples in re, odd samples in im) and a final split pass.
+// the first two complex stages are fused into one radix-4 pass since their
+// twiddles are just 1 and -i, the rest are radix-2 passes that do four
+// butterflies at a time when sse is there
+
+void fft_init(Fft *fft) {
+    int bits = 0;
+    while ((1 << bits) < FFT_HALF) {
+        bits++;
+    }
+
+    for (int i = 0; i < FFT_HALF; i++) {
+        int reversed = 0;
+        for (int b = 0; b < bits; b++) {
+            if (i & (1 << b)) {
+                reversed |= 1 << (bits - 1 - b);
+            }
+        }
+        fft->bitrev[i] = reversed;
+    }
+
+    // the twiddles of the stage with half span h live at [h, 2h)
+    for (int h = 1; h < FFT_HALF; h *= 2) {
+        for (int k = 0; k < h; k++) {
+            double angle = -PI * k / h;
+            fft->twiddle_re[h + k] = cos(angle);
+            fft->twiddle_im[h + k] = sin(angle);
+        }
+    }
+
+    for (int k = 0; k < FFT_HALF; k++) {
+        double angle = -2.0 * PI * k / FFT_SIZE;
+        fft->split_re[k] = cos(angle);
+        fft->split_im[k] = sin(angle);
+    }
+
+    for (int i = 0; i < FFT_SIZE; i++) {
+        fft->window[i] = 0.5f - 0.5f * cosf(2.0f * PI * i / (FFT_SIZE - 1));
+    }
+}
+
+static void fft_radix4_pass(float *re, float *im) {
+    for (int s = 0; s < FFT_HALF; s += 4) {
+        float b0r = re[s] + re[s + 1];
+        float b0i = im[s] + im[s + 1];
+        float b1r = re[s] - re[s + 1];
+        float b1i = im[s] - im[s + 1];
+        float b2r = re[s + 2] + re[s + 3];
+        float b2i = im[s + 2] + im[s + 3];
+        float b3r = re[s + 2] - re[s + 3];
+        float b3i = im[s + 2] - im[s + 3];
+
+        re[s] = b0r + b2r;
+        im[s] = b0i + b2i;
+        re[s + 2] = b0r - b2r;
+        im[s + 2] = b0i - b2i;
+        // b3 * -i
+        re[s + 1] = b1r + b3i;
+        im[s + 1] = b1i - b3r;
+        re[s + 3] = b1r - b3i;
+        im[s + 3] = b1i + b3r;
+    }
+}
+
+static void fft_radix2_pass(Fft *fft, float *re, float *im, int h) {
+    const float *wr = fft->twiddle_re + h;
+    const float *wi = fft->twiddle_im + h;
+
+    for (int s = 0; s < FFT_HALF; s += 2 * h) {
+        float *ar = re + s;
+        float *ai = im + s;
+        float *br = re + s + h;
+        float *bi = im + s + h;
+        int k = 0;
+#ifdef __SSE__
+        for (; k + 4 <= h; k += 4) {
+            __m128 w_re = _mm_loadu_ps(wr + k);
+            __m128 w_im = _mm_loadu_ps(wi + k);
+            __m128 b_re = _mm_loadu_ps(br + k);
+            __m128 b_im = _mm_loadu_ps(bi + k);
+            __m128 t_re = _mm_sub_ps(_mm_mul_ps(b_re, w_re), _mm_mul_ps(b_im, w_im));
+            __m128 t_im = _mm_add_ps(_mm_mul_ps(b_re, w_im), _mm_mul_ps(b_im, w_re));
+            __m128 a_re = _mm_loadu_ps(ar + k);
+            __m128 a_im = _mm_loadu_ps(ai + k);
+            _mm_storeu_ps(br + k, _mm_sub_ps(a_re, t_re));
+            _mm_storeu_ps(bi + k, _mm_sub_ps(a_im, t_im));
+            _mm_storeu_ps(ar + k, _mm_add_ps(a_re, t_re));
+            _mm_storeu_ps(ai + k, _mm_add_ps(a_im, t_im));
+        }
+#endif
+        for (; k < h; k++) {
+            float t_re = br[k] * wr[k] - bi[k] * wi[k];
+            float t_im = br[k] * wi[k] + bi[k] * wr[k];
+            br[k] = ar[k] - t_re;
+            bi[k] = ai[k] - t_im;
+            ar[k] += t_re;
+            ai[k] += t_im;
+        }
+    }
+}
+
+// input holds FFT_SIZE samples, power gets FFT_HALF + 1 bins (dc to nyquist)
+void fft_power_spectrum(Fft *fft, const float *input, float *power) {
+    float *re = fft->re;
+    float *im = fft->im;
+
+    for (int i = 0; i < FFT_HALF; i++) {
+        int j = fft->bitrev[i];
+        re[j] = input[2 * i] * fft->window[2 * i];
+        im[j] = input[2 * i + 1] * fft->window[2 * i + 1];
+    }
+
+    fft_radix4_pass(re, im);
+    for (int h = 4; h < FFT_HALF; h *= 2) {
+        fft_radix2_pass(fft, re, im, h);
+    }
+
+    // X[k] = (Z[k] + conj(Z[H-k])) / 2 - i * W^k * (Z[k] - conj(Z[H-k])) / 2
+    power[0] = (re[0] + im[0]) * (re[0] + im[0]);
+    power[FFT_HALF] = (re[0] - im[0]) * (re[0] - im[0]);
+    for (int k = 1; k < FFT_HALF; k++) {
+        float ar = re[k];
+        float ai = im[k];
+        float br = re[FFT_HALF - k];
+        float bi = -im[FFT_HALF - k];
+
+        float even_r = 0.5f * (ar + br);
+        float even_i = 0.5f * (ai + bi);
+        float diff_r = 0.5f * (ar - br);
+        float diff_i = 0.5f * (ai - bi);
+        float odd_r = diff_i;
+        float odd_i = -diff_r;
+
+        float wr = fft->split_re[k];
+        float wi = fft->split_im[k];
+        float x_r = even_r + (odd_r * wr - odd_i * wi);
+        float x_i = even_i + (odd_r * wi + odd_i * wr);
+        power[k] = x_r * x_r + x_i * x_i;
+    }
+}
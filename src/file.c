@@ -2,6 +2,12 @@ void cmd_save_file() {
     // oh not yet
 }
 
+// on the cmd line until it is dismissed
+void cmd_show_message(const char *text) {
+    snprintf(state->cmd_message, CMD_MAX_MESSAGE, "%s", text);
+    state->state = STATE_MESSAGE;
+}
+
 void cmd_try_add_char(char c) {
     if (state->cmd_cursor < (CMD_MAX_TEXT - 2)) {
         state->cmd_buffer[state->cmd_cursor + 1] = '\0';
@@ -19,8 +25,8 @@ void cmd_try_remove_char() {
 
 bool cmd_enter_file_name() {
     for (int key = KEY_A; key <= KEY_Z; key++) {
-        if (IsKeyPressed(key)) {
-            if (!IsKeyDown(KEY_LEFT_SHIFT) && !IsKeyDown(KEY_RIGHT_SHIFT)) {
+        if (input_key_pressed(key)) {
+            if (!input_shift_down()) {
                 key += 32;
             }
             cmd_try_add_char(key);
@@ -28,15 +34,15 @@ bool cmd_enter_file_name() {
         }
     }
 
-    if (IsKeyPressed(KEY_SPACE)) {
+    if (input_key_pressed(KEY_SPACE)) {
         cmd_try_add_char(' ');
         return false;
     }
 
-    if (IsKeyPressed(KEY_BACKSPACE) || IsKeyPressedRepeat(KEY_BACKSPACE)) {
+    if (input_key_pressed(KEY_BACKSPACE) || input_key_pressed_repeat(KEY_BACKSPACE)) {
         cmd_try_remove_char();
         return false;
     }
 
-    return IsKeyPressed(KEY_ENTER);
+    return input_key_pressed(KEY_ENTER);
 }
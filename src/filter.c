@@ -0,0 +1,80 @@
+#ifdef __SSE__
+    #include <xmmintrin.h>
+#endif
+
+// one zero delay feedback (tpt) state variable lowpass per voice, laid out so
+// the four voices run side by side in one sse register. coefficients only
+// change once per block and are eased towards their new value
+
+// key tracked cutoffs are relative to middle c
+#define FILTER_KEY_TRACKING_REFERENCE 261.63f
+#define FILTER_COEFFICIENT_SMOOTHING 0.5f
+
+void flush_denormals() {
+#ifdef __SSE__
+    // flush to zero + denormals are zero, the filter tails would otherwise
+    // decay into denormals and get very slow
+    _mm_setcsr(_mm_getcsr() | 0x8040);
+#endif
+}
+
+void filter_bank_update(FilterBank *bank, const float *freq, float cutoff, float resonance, float key_tracking, float sample_rate) {
+    float smoothing = bank->primed ? FILTER_COEFFICIENT_SMOOTHING : 1.0f;
+    bank->primed = true;
+
+    float k_target = 2.0f - (2.0f * 0.98f * resonance);
+    bank->k += (k_target - bank->k) * smoothing;
+
+    for (int j = 0; j < FREQ_COUNT; j++) {
+        float voice_cutoff = cutoff * powf(freq[j] / FILTER_KEY_TRACKING_REFERENCE, key_tracking);
+        if (voice_cutoff > sample_rate * 0.45f) {
+            voice_cutoff = sample_rate * 0.45f;
+        }
+        float g_target = tanf(PI * voice_cutoff / sample_rate);
+        bank->g[j] += (g_target - bank->g[j]) * smoothing;
+
+        float g = bank->g[j];
+        bank->a1[j] = 1.0f / (1.0f + g * (g + bank->k));
+        bank->a2[j] = g * bank->a1[j];
+        bank->a3[j] = g * bank->a2[j];
+    }
+}
+
+// filters one sample of every voice in place
+inline static void filter_bank_process(FilterBank *bank, float *voices) {
+#ifdef __SSE__
+    __m128 v0 = _mm_loadu_ps(voices);
+    __m128 ic1eq = _mm_load_ps(bank->ic1eq);
+    __m128 ic2eq = _mm_load_ps(bank->ic2eq);
+    __m128 a1 = _mm_load_ps(bank->a1);
+    __m128 a2 = _mm_load_ps(bank->a2);
+    __m128 a3 = _mm_load_ps(bank->a3);
+
+    __m128 v3 = _mm_sub_ps(v0, ic2eq);
+    __m128 v1 = _mm_add_ps(_mm_mul_ps(a1, ic1eq), _mm_mul_ps(a2, v3));
+    __m128 v2 = _mm_add_ps(ic2eq, _mm_add_ps(_mm_mul_ps(a2, ic1eq), _mm_mul_ps(a3, v3)));
+
+    _mm_store_ps(bank->ic1eq, _mm_sub_ps(_mm_add_ps(v1, v1), ic1eq));
+    _mm_store_ps(bank->ic2eq, _mm_sub_ps(_mm_add_ps(v2, v2), ic2eq));
+    _mm_storeu_ps(voices, v2);
+#else
+    for (int j = 0; j < FREQ_COUNT; j++) {
+        float v3 = voices[j] - bank->ic2eq[j];
+        float v1 = bank->a1[j] * bank->ic1eq[j] + bank->a2[j] * v3;
+        float v2 = bank->ic2eq[j] + bank->a2[j] * bank->ic1eq[j] + bank->a3[j] * v3;
+        bank->ic1eq[j] = 2.0f * v1 - bank->ic1eq[j];
+        bank->ic2eq[j] = 2.0f * v2 - bank->ic2eq[j];
+        voices[j] = v2;
+    }
+#endif
+}
+
+// without sse there is no flush to zero, so the states are cleared by hand
+void filter_bank_flush_denormals(FilterBank *bank) {
+#ifndef __SSE__
+    for (int j = 0; j < FREQ_COUNT; j++) {
+        if (fabsf(bank->ic1eq[j]) < 1e-20f) bank->ic1eq[j] = 0.0f;
+        if (fabsf(bank->ic2eq[j]) < 1e-20f) bank->ic2eq[j] = 0.0f;
+    }
+#endif
+}
@@ -0,0 +1,309 @@
+// a small flac encoder for 16 bit mono: every block is one frame with one
+// subframe, either constant (silence), fixed prediction of order 0 to 4 with
+// rice coded residuals, or verbatim when prediction does not pay off.
+// STREAMINFO is written up front and patched with the real sizes on close
+
+#define FLAC_BLOCK_SIZE 4096
+#define FLAC_MAX_FIXED_ORDER 4
+#define FLAC_MAX_PARTITION_ORDER 6
+#define FLAC_MAX_RICE_PARAMETER 14
+// header + verbatim subframe + footer of a full block, with room to spare
+#define FLAC_MAX_FRAME_SIZE (FLAC_BLOCK_SIZE * 2 + 64)
+#define FLAC_STREAMINFO_OFFSET 8
+#define FLAC_STREAMINFO_SIZE 34
+
+typedef struct FlacBits {
+    uint8 *data;
+    uint32 size;
+    uint64 acc;
+    int acc_bits;
+} FlacBits;
+
+typedef struct FlacWriter {
+    FILE *file;
+    uint32 sample_rate;
+    uint64 total_samples;
+    uint32 frame_number;
+    uint32 min_frame_size;
+    uint32 max_frame_size;
+    uint32 buffered;
+    int16 buffer[FLAC_BLOCK_SIZE];
+    int32 residual[FLAC_BLOCK_SIZE];
+    uint8 frame[FLAC_MAX_FRAME_SIZE];
+} FlacWriter;
+
+static void flac_put_bits(FlacBits *bits, uint32 value, int count) {
+    if (count == 0) {
+        return;
+    }
+    bits->acc = (bits->acc << count) | (value & ((count < 32) ? ((1u << count) - 1) : 0xffffffffu));
+    bits->acc_bits += count;
+    while (bits->acc_bits >= 8) {
+        bits->acc_bits -= 8;
+        bits->data[bits->size++] = (uint8)(bits->acc >> bits->acc_bits);
+    }
+}
+
+static void flac_put_signed(FlacBits *bits, int32 value, int count) {
+    flac_put_bits(bits, (uint32)value, count);
+}
+
+static void flac_put_unary_zeros(FlacBits *bits, uint32 zeros) {
+    while (zeros >= 24) {
+        flac_put_bits(bits, 0, 24);
+        zeros -= 24;
+    }
+    flac_put_bits(bits, 1, zeros + 1);
+}
+
+static void flac_align(FlacBits *bits) {
+    if (bits->acc_bits > 0) {
+        flac_put_bits(bits, 0, 8 - bits->acc_bits);
+    }
+}
+
+static uint8 flac_crc8(const uint8 *data, uint32 size) {
+    uint8 crc = 0;
+    for (uint32 i = 0; i < size; i++) {
+        crc ^= data[i];
+        for (int b = 0; b < 8; b++) {
+            crc = (crc & 0x80) ? (uint8)((crc << 1) ^ 0x07) : (uint8)(crc << 1);
+        }
+    }
+    return crc;
+}
+
+static uint16 flac_crc16(const uint8 *data, uint32 size) {
+    uint16 crc = 0;
+    for (uint32 i = 0; i < size; i++) {
+        crc ^= (uint16)data[i] << 8;
+        for (int b = 0; b < 8; b++) {
+            crc = (crc & 0x8000) ? (uint16)((crc << 1) ^ 0x8005) : (uint16)(crc << 1);
+        }
+    }
+    return crc;
+}
+
+// the frame number is coded like utf-8
+static void flac_put_frame_number(FlacBits *bits, uint32 number) {
+    if (number < 0x80) {
+        flac_put_bits(bits, number, 8);
+        return;
+    }
+    int extra = (number < 0x800) ? 1 : (number < 0x10000) ? 2 : (number < 0x200000) ? 3 : (number < 0x4000000) ? 4 : 5;
+    uint32 lead_mask = (0xff00 >> (extra + 1)) & 0xff;
+    flac_put_bits(bits, lead_mask | (number >> (6 * extra)), 8);
+    for (int i = extra - 1; i >= 0; i--) {
+        flac_put_bits(bits, 0x80 | ((number >> (6 * i)) & 0x3f), 8);
+    }
+}
+
+static void flac_write_streaminfo(FlacWriter *writer) {
+    uint8 data[FLAC_STREAMINFO_SIZE];
+    FlacBits bits = { .data = data };
+    flac_put_bits(&bits, FLAC_BLOCK_SIZE, 16);
+    flac_put_bits(&bits, FLAC_BLOCK_SIZE, 16);
+    flac_put_bits(&bits, writer->min_frame_size, 24);
+    flac_put_bits(&bits, writer->max_frame_size, 24);
+    flac_put_bits(&bits, writer->sample_rate, 20);
+    flac_put_bits(&bits, 0, 3);
+    flac_put_bits(&bits, 15, 5);
+    flac_put_bits(&bits, (uint32)(writer->total_samples >> 32), 4);
+    flac_put_bits(&bits, (uint32)writer->total_samples, 32);
+    // no md5, zero means unknown
+    for (int i = 0; i < 4; i++) {
+        flac_put_bits(&bits, 0, 32);
+    }
+    fwrite(data, 1, FLAC_STREAMINFO_SIZE, writer->file);
+}
+
+bool flac_writer_open(FlacWriter *writer, const char *file_name, uint32 sample_rate) {
+    writer->file = fopen(file_name, "wb");
+    if (writer->file == NULL) {
+        return false;
+    }
+    writer->sample_rate = sample_rate;
+    writer->total_samples = 0;
+    writer->frame_number = 0;
+    writer->min_frame_size = 0;
+    writer->max_frame_size = 0;
+    writer->buffered = 0;
+
+    // "fLaC", then STREAMINFO as the last (and only) metadata block
+    uint8 header[FLAC_STREAMINFO_OFFSET] = { 'f', 'L', 'a', 'C', 0x80, 0, 0, FLAC_STREAMINFO_SIZE };
+    fwrite(header, 1, FLAC_STREAMINFO_OFFSET, writer->file);
+    flac_write_streaminfo(writer);
+    return true;
+}
+
+static void flac_compute_residual(const int16 *x, uint32 n, int order, int32 *residual) {
+    for (uint32 i = order; i < n; i++) {
+        switch (order) {
+            case 0: residual[i] = x[i]; break;
+            case 1: residual[i] = x[i] - x[i - 1]; break;
+            case 2: residual[i] = x[i] - 2 * x[i - 1] + x[i - 2]; break;
+            case 3: residual[i] = x[i] - 3 * x[i - 1] + 3 * x[i - 2] - x[i - 3]; break;
+            case 4: residual[i] = x[i] - 4 * x[i - 1] + 6 * x[i - 2] - 4 * x[i - 3] + x[i - 4]; break;
+        }
+    }
+}
+
+inline static uint32 flac_zigzag(int32 value) {
+    return ((uint32)value << 1) ^ (uint32)(value >> 31);
+}
+
+// rice parameter for a partition from the sum of its zigzagged residuals,
+// along with how many bits the partition then takes
+static int flac_get_rice_parameter(uint64 sum, uint32 count, uint64 *cost) {
+    int k = 0;
+    while (k < FLAC_MAX_RICE_PARAMETER && ((uint64)count << (k + 1)) < sum) {
+        k++;
+    }
+    *cost = 4 + (uint64)count * (k + 1) + (sum >> k);
+    return k;
+}
+
+static uint64 flac_get_partition_cost(const int32 *residual, uint32 n, int order, int partition_order) {
+    uint32 partition_size = n >> partition_order;
+    uint64 cost = 0;
+    for (int p = 0; p < (1 << partition_order); p++) {
+        uint32 start = (p == 0) ? order : p * partition_size;
+        uint32 end = (p + 1) * partition_size;
+        uint64 sum = 0;
+        for (uint32 i = start; i < end; i++) {
+            sum += flac_zigzag(residual[i]);
+        }
+        uint64 partition_cost;
+        flac_get_rice_parameter(sum, end - start, &partition_cost);
+        cost += partition_cost;
+    }
+    return cost;
+}
+
+static void flac_put_residual(FlacBits *bits, const int32 *residual, uint32 n, int order, int partition_order) {
+    uint32 partition_size = n >> partition_order;
+    flac_put_bits(bits, 0, 2);
+    flac_put_bits(bits, partition_order, 4);
+    for (int p = 0; p < (1 << partition_order); p++) {
+        uint32 start = (p == 0) ? order : p * partition_size;
+        uint32 end = (p + 1) * partition_size;
+        uint64 sum = 0;
+        for (uint32 i = start; i < end; i++) {
+            sum += flac_zigzag(residual[i]);
+        }
+        uint64 cost;
+        int k = flac_get_rice_parameter(sum, end - start, &cost);
+        flac_put_bits(bits, k, 4);
+        for (uint32 i = start; i < end; i++) {
+            uint32 u = flac_zigzag(residual[i]);
+            flac_put_unary_zeros(bits, u >> k);
+            flac_put_bits(bits, u, k);
+        }
+    }
+}
+
+static void flac_encode_frame(FlacWriter *writer) {
+    const int16 *x = writer->buffer;
+    uint32 n = writer->buffered;
+    FlacBits bits = { .data = writer->frame };
+
+    flac_put_bits(&bits, 0xfff8, 16);
+    // block size: 4096 has its own code, anything else is spelled out after the frame number
+    flac_put_bits(&bits, (n == FLAC_BLOCK_SIZE) ? 12 : 7, 4);
+    flac_put_bits(&bits, (writer->sample_rate == 44100) ? 9 : 0, 4);
+    flac_put_bits(&bits, 0, 4);
+    flac_put_bits(&bits, 4, 3);
+    flac_put_bits(&bits, 0, 1);
+    flac_put_frame_number(&bits, writer->frame_number);
+    if (n != FLAC_BLOCK_SIZE) {
+        flac_put_bits(&bits, n - 1, 16);
+    }
+    flac_put_bits(&bits, flac_crc8(bits.data, bits.size), 8);
+
+    bool constant = true;
+    for (uint32 i = 1; i < n && constant; i++) {
+        constant = x[i] == x[0];
+    }
+
+    if (constant) {
+        flac_put_bits(&bits, 0x00, 8);
+        flac_put_signed(&bits, x[0], 16);
+    } else {
+        uint64 verbatim_cost = 16 * (uint64)n;
+        uint64 best_cost = verbatim_cost;
+        int best_order = -1;
+        int best_partition_order = 0;
+
+        for (int order = 0; order <= FLAC_MAX_FIXED_ORDER && (uint32)order < n; order++) {
+            flac_compute_residual(x, n, order, writer->residual);
+            for (int partition_order = 0; partition_order <= FLAC_MAX_PARTITION_ORDER; partition_order++) {
+                // partitions have to split the block evenly and hold the warmup samples
+                if ((n % (1u << partition_order)) != 0 || (n >> partition_order) <= (uint32)order) {
+                    break;
+                }
+                uint64 cost = 16 * order + 6 + flac_get_partition_cost(writer->residual, n, order, partition_order);
+                if (cost < best_cost) {
+                    best_cost = cost;
+                    best_order = order;
+                    best_partition_order = partition_order;
+                }
+            }
+        }
+
+        if (best_order < 0) {
+            flac_put_bits(&bits, 0x02, 8);
+            for (uint32 i = 0; i < n; i++) {
+                flac_put_signed(&bits, x[i], 16);
+            }
+        } else {
+            flac_put_bits(&bits, 0x10 | (best_order << 1), 8);
+            for (int i = 0; i < best_order; i++) {
+                flac_put_signed(&bits, x[i], 16);
+            }
+            flac_compute_residual(x, n, best_order, writer->residual);
+            flac_put_residual(&bits, writer->residual, n, best_order, best_partition_order);
+        }
+    }
+
+    flac_align(&bits);
+    uint16 crc = flac_crc16(bits.data, bits.size);
+    flac_put_bits(&bits, crc, 16);
+
+    fwrite(bits.data, 1, bits.size, writer->file);
+
+    if (writer->frame_number == 0 || bits.size < writer->min_frame_size) {
+        writer->min_frame_size = bits.size;
+    }
+    if (bits.size > writer->max_frame_size) {
+        writer->max_frame_size = bits.size;
+    }
+    writer->total_samples += n;
+    writer->frame_number++;
+    writer->buffered = 0;
+}
+
+void flac_writer_write(FlacWriter *writer, const int16 *samples, uint32 count) {
+    while (count > 0) {
+        uint32 space = FLAC_BLOCK_SIZE - writer->buffered;
+        uint32 n = (count < space) ? count : space;
+        memcpy(writer->buffer + writer->buffered, samples, n * sizeof(int16));
+        writer->buffered += n;
+        samples += n;
+        count -= n;
+        if (writer->buffered == FLAC_BLOCK_SIZE) {
+            flac_encode_frame(writer);
+        }
+    }
+}
+
+bool flac_writer_close(FlacWriter *writer) {
+    if (writer->buffered > 0) {
+        flac_encode_frame(writer);
+    }
+    fseek(writer->file, FLAC_STREAMINFO_OFFSET, SEEK_SET);
+    flac_write_streaminfo(writer);
+    bool ok = !ferror(writer->file);
+    ok = (fclose(writer->file) == 0) && ok;
+    writer->file = NULL;
+    return ok;
+}
@@ -0,0 +1,360 @@
+#define FONT_CACHE_FILE "font.cache"
+#define FONT_CACHE_MAGIC 0x43465054 // "TPFC"
+#define FONT_CACHE_VERSION 2
+
+// every codepoint comes from the first font in this list that has it,
+// so the UI text uses arial and the music symbols fall through to noto
+static const char *font_files[] = {
+    "arial.ttf",
+    "NotoMusic-Regular.ttf",
+};
+
+#define FONT_FILE_COUNT (sizeof(font_files) / sizeof(font_files[0]))
+
+typedef struct FontFile {
+    unsigned char *data;
+    int size;
+} FontFile;
+
+// the glyphs are stored as signed distance fields so this can stay small,
+// the shader below reconstructs a sharp edge at whatever size we draw them
+#define FONT_SDF_SIZE 32
+
+static const char *font_sdf_shader_code =
+    "#version 330\n"
+    "in vec2 fragTexCoord;\n"
+    "in vec4 fragColor;\n"
+    "uniform sampler2D texture0;\n"
+    "uniform vec4 colDiffuse;\n"
+    "out vec4 finalColor;\n"
+    "void main() {\n"
+    "    float distance = texture(texture0, fragTexCoord).a - 0.5;\n"
+    "    float width = max(length(vec2(dFdx(distance), dFdy(distance))), 0.0001);\n"
+    "    float alpha = smoothstep(-width, width, distance);\n"
+    "    finalColor = vec4(fragColor.rgb, fragColor.a * alpha) * colDiffuse;\n"
+    "}\n";
+
+typedef struct FontCacheHeader {
+    uint32 magic;
+    uint32 version;
+    uint64 font_hash;
+    int32 base_size;
+    int32 glyph_count;
+    int32 atlas_width;
+    int32 atlas_height;
+    int32 atlas_format;
+    int32 atlas_size;
+} FontCacheHeader;
+
+typedef struct FontCacheGlyph {
+    int32 value;
+    int32 offset_x;
+    int32 offset_y;
+    int32 advance_x;
+    Rectangle rec;
+} FontCacheGlyph;
+
+static int font_codepoints[] = {
+    CHAR_SINGLE_8TH_NOTE,
+    CHAR_BEAMED_8TH_NOTES,
+    CHAR_SHARP,
+    CHAR_FLAT,
+    CHAR_DIMINISHED,
+};
+
+#define FONT_ASCII_START 32
+#define FONT_ASCII_END 126
+#define FONT_EXTRA_CODEPOINT_COUNT (sizeof(font_codepoints) / sizeof(font_codepoints[0]))
+#define FONT_CODEPOINT_COUNT ((FONT_ASCII_END - FONT_ASCII_START + 1) + FONT_EXTRA_CODEPOINT_COUNT)
+
+static void get_font_codepoints(int *codepoints) {
+    int count = 0;
+    for (int c = FONT_ASCII_START; c <= FONT_ASCII_END; c++) {
+        codepoints[count++] = c;
+    }
+    for (int i = 0; i < FONT_EXTRA_CODEPOINT_COUNT; i++) {
+        codepoints[count++] = font_codepoints[i];
+    }
+}
+
+// fnv-1a over the font files and everything else that ends up in the atlas,
+// a cache built from different fonts or glyphs never matches
+static uint64 get_font_hash(FontFile *files, const int *codepoints) {
+    uint64 hash = 0xcbf29ce484222325;
+    uint64 prime = 0x100000001b3;
+
+    for (int i = 0; i < FONT_FILE_COUNT; i++) {
+        for (int j = 0; j < files[i].size; j++) {
+            hash = (hash ^ files[i].data[j]) * prime;
+        }
+        hash = (hash ^ (uint64)files[i].size) * prime;
+    }
+
+    for (int i = 0; i < FONT_CODEPOINT_COUNT; i++) {
+        hash = (hash ^ (uint64)codepoints[i]) * prime;
+    }
+
+    return (hash ^ FONT_SDF_SIZE) * prime;
+}
+
+static bool load_font_cache(Font *font, const int *codepoints, uint64 font_hash) {
+    int data_size = 0;
+    unsigned char *data = LoadFileData(FONT_CACHE_FILE, &data_size);
+    if (data == NULL) {
+        return false;
+    }
+
+    bool valid = false;
+    FontCacheHeader *header = (FontCacheHeader *)data;
+    FontCacheGlyph *glyphs = (FontCacheGlyph *)(data + sizeof(FontCacheHeader));
+    int glyphs_size = FONT_CODEPOINT_COUNT * sizeof(FontCacheGlyph);
+
+    if (
+        data_size >= (int)sizeof(FontCacheHeader) &&
+        header->magic == FONT_CACHE_MAGIC &&
+        header->version == FONT_CACHE_VERSION &&
+        header->font_hash == font_hash &&
+        header->base_size == FONT_SDF_SIZE &&
+        header->glyph_count == FONT_CODEPOINT_COUNT &&
+        header->atlas_size == GetPixelDataSize(header->atlas_width, header->atlas_height, header->atlas_format) &&
+        data_size == (int)sizeof(FontCacheHeader) + glyphs_size + header->atlas_size
+    ) {
+        valid = true;
+        for (int i = 0; i < FONT_CODEPOINT_COUNT; i++) {
+            if (glyphs[i].value != codepoints[i]) {
+                valid = false;
+                break;
+            }
+        }
+    }
+
+    if (valid) {
+        font->baseSize = header->base_size;
+        font->glyphCount = header->glyph_count;
+        font->glyphPadding = 0;
+        font->recs = (Rectangle *)MemAlloc(font->glyphCount * sizeof(Rectangle));
+        font->glyphs = (GlyphInfo *)MemAlloc(font->glyphCount * sizeof(GlyphInfo));
+        for (int i = 0; i < font->glyphCount; i++) {
+            font->recs[i] = glyphs[i].rec;
+            font->glyphs[i].value = glyphs[i].value;
+            font->glyphs[i].offsetX = glyphs[i].offset_x;
+            font->glyphs[i].offsetY = glyphs[i].offset_y;
+            font->glyphs[i].advanceX = glyphs[i].advance_x;
+        }
+
+        Image atlas = {
+            .data = data + sizeof(FontCacheHeader) + glyphs_size,
+            .width = header->atlas_width,
+            .height = header->atlas_height,
+            .mipmaps = 1,
+            .format = header->atlas_format,
+        };
+        font->texture = LoadTextureFromImage(atlas);
+    }
+
+    UnloadFileData(data);
+    return valid;
+}
+
+static void save_font_cache(Font font, Image atlas, uint64 font_hash) {
+    int glyphs_size = font.glyphCount * sizeof(FontCacheGlyph);
+    int atlas_size = GetPixelDataSize(atlas.width, atlas.height, atlas.format);
+    int data_size = sizeof(FontCacheHeader) + glyphs_size + atlas_size;
+    unsigned char *data = (unsigned char *)MemAlloc(data_size);
+
+    FontCacheHeader *header = (FontCacheHeader *)data;
+    header->magic = FONT_CACHE_MAGIC;
+    header->version = FONT_CACHE_VERSION;
+    header->font_hash = font_hash;
+    header->base_size = font.baseSize;
+    header->glyph_count = font.glyphCount;
+    header->atlas_width = atlas.width;
+    header->atlas_height = atlas.height;
+    header->atlas_format = atlas.format;
+    header->atlas_size = atlas_size;
+
+    FontCacheGlyph *glyphs = (FontCacheGlyph *)(data + sizeof(FontCacheHeader));
+    for (int i = 0; i < font.glyphCount; i++) {
+        glyphs[i].value = font.glyphs[i].value;
+        glyphs[i].offset_x = font.glyphs[i].offsetX;
+        glyphs[i].offset_y = font.glyphs[i].offsetY;
+        glyphs[i].advance_x = font.glyphs[i].advanceX;
+        glyphs[i].rec = font.recs[i];
+    }
+
+    memcpy(data + sizeof(FontCacheHeader) + glyphs_size, atlas.data, atlas_size);
+    SaveFileData(FONT_CACHE_FILE, data, data_size);
+    MemFree(data);
+}
+
+static int find_codepoint(const int *codepoints, int value) {
+    for (int i = 0; i < FONT_CODEPOINT_COUNT; i++) {
+        if (codepoints[i] == value) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static bool generate_sdf_font(Font *font, FontFile *files, int *codepoints, uint64 font_hash) {
+    GlyphInfo *glyphs = (GlyphInfo *)MemAlloc(FONT_CODEPOINT_COUNT * sizeof(GlyphInfo));
+    bool found[FONT_CODEPOINT_COUNT] = {0};
+    int found_count = 0;
+
+    for (int i = 0; i < FONT_CODEPOINT_COUNT; i++) {
+        glyphs[i].value = codepoints[i];
+    }
+
+    for (int i = 0; i < FONT_FILE_COUNT && found_count < FONT_CODEPOINT_COUNT; i++) {
+        if (files[i].data == NULL) {
+            continue;
+        }
+
+        int missing[FONT_CODEPOINT_COUNT];
+        int missing_count = 0;
+        for (int j = 0; j < FONT_CODEPOINT_COUNT; j++) {
+            if (!found[j]) {
+                missing[missing_count++] = codepoints[j];
+            }
+        }
+
+        GlyphInfo *loaded = LoadFontData(files[i].data, files[i].size, FONT_SDF_SIZE, missing, missing_count, FONT_SDF);
+        if (loaded == NULL) {
+            continue;
+        }
+
+        // raylib leaves glyphs the font does not have without an image or advance
+        for (int j = 0; j < missing_count; j++) {
+            int idx = find_codepoint(codepoints, loaded[j].value);
+            bool has_glyph = loaded[j].image.data != NULL || loaded[j].advanceX > 0;
+            if (idx >= 0 && !found[idx] && has_glyph) {
+                glyphs[idx] = loaded[j];
+                found[idx] = true;
+                found_count++;
+            } else {
+                UnloadImage(loaded[j].image);
+            }
+        }
+        MemFree(loaded);
+    }
+
+    if (found_count == 0) {
+        MemFree(glyphs);
+        return false;
+    }
+
+    font->baseSize = FONT_SDF_SIZE;
+    font->glyphCount = FONT_CODEPOINT_COUNT;
+    font->glyphPadding = 0;
+    font->glyphs = glyphs;
+
+    Image atlas = GenImageFontAtlas(font->glyphs, &font->recs, font->glyphCount, font->baseSize, font->glyphPadding, 1);
+    font->texture = LoadTextureFromImage(atlas);
+
+    // the per glyph images are only needed to build the atlas
+    for (int i = 0; i < font->glyphCount; i++) {
+        UnloadImage(font->glyphs[i].image);
+        font->glyphs[i].image = (Image){0};
+    }
+
+    save_font_cache(*font, atlas, font_hash);
+    UnloadImage(atlas);
+    return true;
+}
+
+void load_font() {
+    int codepoints[FONT_CODEPOINT_COUNT];
+    get_font_codepoints(codepoints);
+
+    FontFile files[FONT_FILE_COUNT];
+    for (int i = 0; i < FONT_FILE_COUNT; i++) {
+        files[i].size = 0;
+        files[i].data = FileExists(font_files[i]) ? LoadFileData(font_files[i], &files[i].size) : NULL;
+    }
+
+    uint64 font_hash = get_font_hash(files, codepoints);
+
+    Font font = {0};
+    bool loaded = load_font_cache(&font, codepoints, font_hash) || generate_sdf_font(&font, files, codepoints, font_hash);
+
+    for (int i = 0; i < FONT_FILE_COUNT; i++) {
+        UnloadFileData(files[i].data);
+    }
+
+    state->font_spacing = 2;
+
+    if (!loaded) {
+        // nothing usable on disk, raylib's own font is better than no text at all
+        state->font = GetFontDefault();
+        return;
+    }
+
+    SetTextureFilter(font.texture, TEXTURE_FILTER_BILINEAR);
+    state->font = font;
+    state->font_shader = LoadShaderFromMemory(NULL, font_sdf_shader_code);
+    state->font_is_sdf = true;
+}
+
+void unload_font() {
+    if (state->font_is_sdf) {
+        UnloadShader(state->font_shader);
+        UnloadFont(state->font);
+    }
+}
+
+Vector2 measure_text(const char *text) {
+    profile_begin(PROFILE_SECTION_TEXT);
+    Vector2 dimensions = MeasureTextEx(state->font, text, font_size(), state->font_spacing);
+    profile_end(PROFILE_SECTION_TEXT);
+    return dimensions;
+}
+
+// all of it in one shader change, the glyphs come from the one atlas
+static void draw_text_queue() {
+    TextQueue *queue = &state->text_queue;
+    if (queue->count == 0) {
+        return;
+    }
+    if (state->font_is_sdf) {
+        draw_batch_begin_shader(state->font_shader);
+    }
+    for (int i = 0; i < queue->count; i++) {
+        QueuedText *item = &queue->items[i];
+        DrawTextPro(state->font, &queue->chars[item->offset], item->position, item->origin, 0, font_size(), state->font_spacing, item->color);
+    }
+    if (state->font_is_sdf) {
+        draw_batch_end_shader();
+    }
+    queue->count = 0;
+    queue->char_count = 0;
+}
+
+// text only shows up with the next draw_queued_text, on top of every shape
+// drawn until then
+void draw_text(const char *text, Vector2 position, Vector2 origin, Color color) {
+    profile_begin(PROFILE_SECTION_TEXT);
+    TextQueue *queue = &state->text_queue;
+    int length = (int)strlen(text);
+    if (length >= TEXT_QUEUE_CHARS) {
+        length = TEXT_QUEUE_CHARS - 1;
+    }
+    if (queue->count == TEXT_QUEUE_CAPACITY || queue->char_count + length + 1 > TEXT_QUEUE_CHARS) {
+        draw_text_queue();
+    }
+
+    QueuedText *item = &queue->items[queue->count++];
+    item->offset = queue->char_count;
+    item->position = position;
+    item->origin = origin;
+    item->color = color;
+    memcpy(&queue->chars[queue->char_count], text, length);
+    queue->chars[queue->char_count + length] = '\0';
+    queue->char_count += length + 1;
+    profile_end(PROFILE_SECTION_TEXT);
+}
+
+void draw_queued_text() {
+    profile_begin(PROFILE_SECTION_TEXT);
+    draw_text_queue();
+    profile_end(PROFILE_SECTION_TEXT);
+}
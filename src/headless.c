@@ -0,0 +1,128 @@
+// renders the ui into an offscreen texture at any size instead of the
+// window, which stays hidden, and writes what came out as a png next to the
+// per frame timings:
+//     main --headless 3840x2160,640x360 [frames] [file.mid]
+// it still needs a gl context. on a box without a display that is
+// xvfb-run with LIBGL_ALWAYS_SOFTWARE=1 for mesa's software renderer
+
+#define HEADLESS_DIRECTORY "headless"
+#define HEADLESS_FRAMES_DEFAULT 60
+
+// true when the arguments ask for it, the sizes and counts are filled in
+bool headless_parse_args(int argc, char **argv) {
+    Headless *headless = &state->headless;
+    if (argc < 3 || strcmp(argv[1], "--headless") != 0) {
+        return false;
+    }
+
+    const char *sizes = argv[2];
+    int consumed = 0;
+    while (headless->size_count < HEADLESS_MAX_SIZES) {
+        int width, height;
+        if (sscanf(sizes, "%ix%i%n", &width, &height, &consumed) != 2 || width <= 0 || height <= 0) {
+            break;
+        }
+        headless->widths[headless->size_count] = width;
+        headless->heights[headless->size_count] = height;
+        headless->size_count++;
+        sizes += consumed;
+        if (*sizes != ',') {
+            break;
+        }
+        sizes++;
+    }
+    if (headless->size_count == 0) {
+        printf("headless: no sizes in \"%s\", they go like 1920x1080,640x360\n", argv[2]);
+        return false;
+    }
+
+    headless->frame_count = (argc > 3) ? atoi(argv[3]) : HEADLESS_FRAMES_DEFAULT;
+    if (headless->frame_count < 1) {
+        headless->frame_count = 1;
+    }
+    headless->midi_file = (argc > 4) ? argv[4] : NULL;
+    headless->enabled = true;
+    return true;
+}
+
+static bool headless_write_timings(const char *file_name, int width, int height, const double *frame_times, int frame_count) {
+    FILE *file = fopen(file_name, "w");
+    if (file == NULL) {
+        return false;
+    }
+    fprintf(file, "{\n  \"width\": %i,\n  \"height\": %i,\n  \"frames\": [", width, height);
+    for (int i = 0; i < frame_count; i++) {
+        ProfileFrame *frame = get_profile_frame(frame_count - 1 - i);
+        fprintf(file, "%s\n    { \"total_ms\": %.4f", (i == 0) ? "" : ",", 1000.0 * frame_times[i]);
+        fprintf(file, ", \"draw_calls\": %u, \"vertices\": %u, \"batch_flushes\": %u", frame->draw_calls, frame->vertices, frame->batch_flushes);
+        for (int section = 0; section < PROFILE_SECTION_COUNT; section++) {
+            fprintf(file, ", \"%s_ms\": %.4f", get_profile_section_name(section), 1000.0 * frame->section_time[section]);
+        }
+        fprintf(file, " }");
+    }
+    fprintf(file, "\n  ]\n}\n");
+    return fclose(file) == 0;
+}
+
+// frame times cover drawing and handing the batch to the gpu. the readback
+// for the png comes after the last frame and is not in them
+static void render_headless_size(int width, int height) {
+    Headless *headless = &state->headless;
+    RenderTexture2D target = LoadRenderTexture(width, height);
+    refresh_layout(width, height);
+    state->mouse_position = (Vector2){ -1.0f, -1.0f };
+
+    // the profiler ring only keeps so many, the timings come out of it
+    int frame_count = (headless->frame_count < PROFILE_FRAME_COUNT) ? headless->frame_count : PROFILE_FRAME_COUNT - 1;
+    double frame_times[PROFILE_FRAME_COUNT];
+
+    for (int i = 0; i < frame_count; i++) {
+        profile_begin_frame();
+        double start = GetTime();
+
+        BeginDrawing();
+        BeginTextureMode(target);
+        draw_frame();
+        profile_begin(PROFILE_SECTION_END_DRAWING);
+        EndTextureMode();
+        EndDrawing();
+        profile_end(PROFILE_SECTION_END_DRAWING);
+
+        frame_times[i] = GetTime() - start;
+    }
+
+    // the texture is upside down as far as images go
+    Image image = LoadImageFromTexture(target.texture);
+    ImageFlipVertical(&image);
+    const char *image_file = TextFormat("%s/%ix%i.png", HEADLESS_DIRECTORY, width, height);
+    bool image_ok = ExportImage(image, image_file);
+    UnloadImage(image);
+    UnloadRenderTexture(target);
+
+    const char *timings_file = TextFormat("%s/%ix%i.json", HEADLESS_DIRECTORY, width, height);
+    bool timings_ok = headless_write_timings(timings_file, width, height, frame_times, frame_count);
+
+    double total = 0.0;
+    for (int i = 0; i < frame_count; i++) {
+        total += frame_times[i];
+    }
+    printf(
+        "headless: %ix%i %s, %i frames at %.3fms on average\n",
+        width, height, (image_ok && timings_ok) ? "written" : "could not be written", frame_count, 1000.0 * total / frame_count
+    );
+}
+
+void render_headless() {
+    Headless *headless = &state->headless;
+    // nothing waits for the frame rate here, render() is the only one that does
+    MakeDirectory(HEADLESS_DIRECTORY);
+    if (headless->midi_file != NULL) {
+        uint8 result = import_midi(headless->midi_file);
+        if (result != MIDI_IMPORT_OK) {
+            printf("headless: could not load %s: %s\n", headless->midi_file, get_midi_import_result_name(result));
+        }
+    }
+    for (int i = 0; i < headless->size_count; i++) {
+        render_headless_size(headless->widths[i], headless->heights[i]);
+    }
+}
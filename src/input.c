@@ -0,0 +1,244 @@
+// everything update() wants to know about the keyboard, mouse and window
+// goes through here, so a session can be recorded and played back.
+// --record FILE writes a frame whenever the input differs from what the
+// frame before would carry over. --replay FILE feeds that back frame by
+// frame instead of raylib, as fast as the frames can be drawn, with the
+// engine moved on a fixed amount per frame instead of by the audio device.
+// the frame times are printed at the end. dropped files and midi input
+// are not recorded
+
+#define INPUT_FILE_MAGIC 0x4e495054 // "TPIN"
+#define INPUT_FILE_VERSION 1
+// every key raylib knows, KEY_KB_MENU is the last one
+#define INPUT_KEY_LIMIT (KEY_KB_MENU + 1)
+#define INPUT_MOUSE_BUTTON_COUNT 3
+
+// what a frame without a record looks like: the keys and buttons that
+// were only pressed for that one frame are gone again
+static InputFrame input_carry(const InputFrame *frame) {
+    InputFrame carried;
+    memset(&carried, 0, sizeof(InputFrame));
+    carried.mouse_position = frame->mouse_position;
+    carried.screen_width = frame->screen_width;
+    carried.screen_height = frame->screen_height;
+    for (int i = 0; i < frame->key_count; i++) {
+        if ((frame->keys[i] & INPUT_KEY_DOWN) != 0) {
+            carried.keys[carried.key_count++] = (frame->keys[i] & INPUT_KEY_MASK) | INPUT_KEY_DOWN;
+        }
+    }
+    return carried;
+}
+
+// zeroed first so two frames can be compared with memcmp
+static void input_sample(InputFrame *frame) {
+    memset(frame, 0, sizeof(InputFrame));
+    frame->mouse_position = GetMousePosition();
+    frame->screen_width = GetScreenWidth();
+    frame->screen_height = GetScreenHeight();
+    for (int button = 0; button < INPUT_MOUSE_BUTTON_COUNT; button++) {
+        if (IsMouseButtonPressed(button)) {
+            frame->mouse_pressed |= 1 << button;
+        }
+    }
+    for (int key = 1; key < INPUT_KEY_LIMIT && frame->key_count < INPUT_MAX_KEYS; key++) {
+        uint16 flags = 0;
+        if (IsKeyDown(key)) {
+            flags |= INPUT_KEY_DOWN;
+        }
+        if (IsKeyPressed(key)) {
+            flags |= INPUT_KEY_PRESSED;
+        }
+        if (IsKeyPressedRepeat(key)) {
+            flags |= INPUT_KEY_REPEAT;
+        }
+        if (flags != 0) {
+            frame->keys[frame->key_count++] = key | flags;
+        }
+    }
+}
+
+// field by field, the file has no padding
+static void input_write_frame(FILE *file, uint32 frame_idx, const InputFrame *frame) {
+    fwrite(&frame_idx, sizeof(uint32), 1, file);
+    fwrite(&frame->mouse_position.x, sizeof(float), 1, file);
+    fwrite(&frame->mouse_position.y, sizeof(float), 1, file);
+    fwrite(&frame->screen_width, sizeof(uint16), 1, file);
+    fwrite(&frame->screen_height, sizeof(uint16), 1, file);
+    fwrite(&frame->mouse_pressed, sizeof(uint8), 1, file);
+    fwrite(&frame->key_count, sizeof(uint8), 1, file);
+    fwrite(frame->keys, sizeof(uint16), frame->key_count, file);
+}
+
+static bool input_read_frame(FILE *file, uint32 *frame_idx, InputFrame *frame) {
+    memset(frame, 0, sizeof(InputFrame));
+    bool ok = (
+        fread(frame_idx, sizeof(uint32), 1, file) == 1 &&
+        fread(&frame->mouse_position.x, sizeof(float), 1, file) == 1 &&
+        fread(&frame->mouse_position.y, sizeof(float), 1, file) == 1 &&
+        fread(&frame->screen_width, sizeof(uint16), 1, file) == 1 &&
+        fread(&frame->screen_height, sizeof(uint16), 1, file) == 1 &&
+        fread(&frame->mouse_pressed, sizeof(uint8), 1, file) == 1 &&
+        fread(&frame->key_count, sizeof(uint8), 1, file) == 1 &&
+        frame->key_count <= INPUT_MAX_KEYS
+    );
+    return ok && fread(frame->keys, sizeof(uint16), frame->key_count, file) == frame->key_count;
+}
+
+static void input_read_next(Input *input) {
+    input->has_next = input_read_frame(input->file, &input->next_frame, &input->next);
+}
+
+void input_start(int argc, char **argv) {
+    Input *input = &state->input;
+    input->mode = INPUT_MODE_LIVE;
+    if (argc < 3) {
+        return;
+    }
+
+    uint32 header[2];
+    if (strcmp(argv[1], "--record") == 0) {
+        input->file = fopen(argv[2], "wb");
+        if (input->file == NULL) {
+            printf("input: could not create %s\n", argv[2]);
+            return;
+        }
+        header[0] = INPUT_FILE_MAGIC;
+        header[1] = INPUT_FILE_VERSION;
+        fwrite(header, sizeof(header), 1, input->file);
+        input->mode = INPUT_MODE_RECORD;
+        printf("input: recording to %s\n", argv[2]);
+    } else if (strcmp(argv[1], "--replay") == 0) {
+        input->file = fopen(argv[2], "rb");
+        if (input->file == NULL) {
+            printf("input: could not open %s\n", argv[2]);
+            return;
+        }
+        if (fread(header, sizeof(header), 1, input->file) != 1 || header[0] != INPUT_FILE_MAGIC || header[1] != INPUT_FILE_VERSION) {
+            printf("input: %s is not an input recording\n", argv[2]);
+            fclose(input->file);
+            input->file = NULL;
+            return;
+        }
+        input->mode = INPUT_MODE_REPLAY;
+        input_read_next(input);
+        if (input->has_next) {
+            SetWindowSize(input->next.screen_width, input->next.screen_height);
+        }
+        state->frame_time = 0.0;
+        input->start_time = GetTime();
+    }
+}
+
+void input_begin_frame() {
+    Input *input = &state->input;
+    input->previous = input->current;
+
+    switch (input->mode) {
+        case INPUT_MODE_LIVE: {
+            input_sample(&input->current);
+        } break;
+        case INPUT_MODE_RECORD: {
+            input_sample(&input->current);
+            InputFrame carried = input_carry(&input->previous);
+            input->wrote_frame = input->frame == 0 || memcmp(&input->current, &carried, sizeof(InputFrame)) != 0;
+            if (input->wrote_frame) {
+                input_write_frame(input->file, input->frame, &input->current);
+            }
+        } break;
+        case INPUT_MODE_REPLAY: {
+            if (input->has_next && input->next_frame <= input->frame) {
+                input->current = input->next;
+                input_read_next(input);
+            } else {
+                input->current = input_carry(&input->previous);
+            }
+            if (!input->has_next) {
+                input->finished = true;
+            }
+        } break;
+    }
+
+    input->frame++;
+}
+
+bool input_finished() {
+    return state->input.finished;
+}
+
+static void input_print_replay_summary() {
+    Input *input = &state->input;
+    double elapsed = GetTime() - input->start_time;
+    printf("replay: %u frames in %.3fs, %.3fms per frame\n", input->frame, elapsed, 1000.0 * elapsed / input->frame);
+    for (int section = 0; section < PROFILE_SECTION_COUNT; section++) {
+        double p50, p99;
+        get_profile_percentiles(section, &p50, &p99);
+        printf("replay: %-16s p50 %.3fms p99 %.3fms\n", get_profile_section_name(section), 1000.0 * p50, 1000.0 * p99);
+    }
+    export_profile_trace(PROFILE_TRACE_FILE);
+}
+
+void input_finish() {
+    Input *input = &state->input;
+    if (input->file == NULL) {
+        return;
+    }
+    if (input->mode == INPUT_MODE_REPLAY) {
+        input_print_replay_summary();
+    } else if (!input->wrote_frame) {
+        // the replay ends on the last record, this one marks the last frame
+        input_write_frame(input->file, input->frame - 1, &input->current);
+    }
+    fclose(input->file);
+    input->file = NULL;
+}
+
+inline static const uint16 *input_find_key(int key) {
+    InputFrame *frame = &state->input.current;
+    for (int i = 0; i < frame->key_count; i++) {
+        if ((frame->keys[i] & INPUT_KEY_MASK) == key) {
+            return &frame->keys[i];
+        }
+    }
+    return NULL;
+}
+
+inline static bool input_key_pressed(int key) {
+    const uint16 *found = input_find_key(key);
+    return found != NULL && (*found & INPUT_KEY_PRESSED) != 0;
+}
+
+inline static bool input_key_pressed_repeat(int key) {
+    const uint16 *found = input_find_key(key);
+    return found != NULL && (*found & INPUT_KEY_REPEAT) != 0;
+}
+
+inline static bool input_key_down(int key) {
+    const uint16 *found = input_find_key(key);
+    return found != NULL && (*found & INPUT_KEY_DOWN) != 0;
+}
+
+inline static bool input_shift_down() {
+    return input_key_down(KEY_LEFT_SHIFT) || input_key_down(KEY_RIGHT_SHIFT);
+}
+
+inline static bool input_mouse_pressed(int button) {
+    return (state->input.current.mouse_pressed & (1 << button)) != 0;
+}
+
+inline static Vector2 input_mouse_position() {
+    return state->input.current.mouse_position;
+}
+
+inline static bool input_window_resized() {
+    InputFrame *current = &state->input.current;
+    InputFrame *previous = &state->input.previous;
+    return current->screen_width != previous->screen_width || current->screen_height != previous->screen_height;
+}
+
+inline static int input_screen_width() {
+    return state->input.current.screen_width;
+}
+
+inline static int input_screen_height() {
+    return state->input.current.screen_height;
+}
@@ -0,0 +1,177 @@
+#include <time.h>
+
+// the log. writing a record takes no lock and no allocation, so the audio
+// thread can log and assert like any other. records are fixed size and keep
+// only numbers and string literals, the log thread turns them into text.
+// each slot counts its own turns: even while it waits for a writer, odd while
+// it waits for the reader. a writer claims a position only when the slot is
+// on its turn for that lap, a slot still waiting for the reader means the
+// ring is full and the record is dropped
+
+#define LOG_DRAIN_INTERVAL_NS 10000000
+
+static Log engine_log;
+
+static const char *log_formats[LOG_CODE_COUNT] = {
+    [LOG_CODE_ASSERT] = "%s:%i: (%s)",
+    [LOG_CODE_RECORDER_DROPPED] = "recorder: dropped %.0f samples, the ring was full",
+};
+
+static const char *get_log_level_name(uint8 level) {
+    switch (level) {
+        case LOG_LEVEL_INFO: return "info";
+        case LOG_LEVEL_WARNING: return "warning";
+        case LOG_LEVEL_ERROR: return "error";
+        case LOG_LEVEL_FATAL: return "fatal";
+    }
+    return "?";
+}
+
+static uint64 log_now() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static void log_push(uint8 level, uint16 code, const char *text, const char *file, int line, const double *args) {
+    Log *log = &engine_log;
+    uint32 idx = atomic_load_explicit(&log->write_idx, memory_order_relaxed);
+    LogRecord *record;
+
+    for (;;) {
+        record = &log->ring[idx & LOG_RING_MASK];
+        uint32 turn = 2 * (idx / LOG_RING_CAPACITY);
+        int32 diff = (int32)(atomic_load_explicit(&record->sequence, memory_order_acquire) - turn);
+        if (diff == 0) {
+            if (atomic_compare_exchange_weak_explicit(&log->write_idx, &idx, idx + 1, memory_order_relaxed, memory_order_relaxed)) {
+                break;
+            }
+        } else if (diff < 0) {
+            atomic_fetch_add_explicit(&log->dropped, 1, memory_order_relaxed);
+            return;
+        } else {
+            idx = atomic_load_explicit(&log->write_idx, memory_order_relaxed);
+        }
+    }
+
+    record->level = level;
+    record->code = code;
+    record->time_ns = log_now();
+    record->text = text;
+    record->file = file;
+    record->line = line;
+    memcpy(record->args, args, sizeof(record->args));
+    atomic_store_explicit(&record->sequence, 2 * (idx / LOG_RING_CAPACITY) + 1, memory_order_release);
+}
+
+void log_write(uint8 level, uint16 code, const double *args) {
+    log_push(level, code, NULL, NULL, 0, args);
+}
+
+// since log_start, or since the first line when it was never started
+static double log_get_seconds(uint64 time_ns) {
+    if (engine_log.start_ns == 0) {
+        engine_log.start_ns = time_ns;
+    }
+    return (int64)(time_ns - engine_log.start_ns) / 1e9;
+}
+
+static void log_print(const LogRecord *record) {
+    printf("[%9.3f] %s: ", log_get_seconds(record->time_ns), get_log_level_name(record->level));
+    if (record->code == LOG_CODE_ASSERT) {
+        printf(log_formats[LOG_CODE_ASSERT], record->file, record->line, record->text);
+    } else {
+        const double *args = record->args;
+        printf(log_formats[record->code], args[0], args[1], args[2], args[3]);
+    }
+    printf("\n");
+}
+
+// only ever one thread in here, the log thread or whoever stopped it
+static void log_drain() {
+    Log *log = &engine_log;
+    for (;;) {
+        LogRecord *record = &log->ring[log->read_idx & LOG_RING_MASK];
+        uint32 turn = 2 * (log->read_idx / LOG_RING_CAPACITY);
+        if (atomic_load_explicit(&record->sequence, memory_order_acquire) != turn + 1) {
+            break;
+        }
+        log_print(record);
+        atomic_store_explicit(&record->sequence, turn + 2, memory_order_release);
+        log->read_idx++;
+    }
+
+    uint32 dropped = atomic_exchange_explicit(&log->dropped, 0, memory_order_relaxed);
+    if (dropped > 0) {
+        printf("[%9.3f] warning: log: %u records did not fit\n", log_get_seconds(log_now()), dropped);
+    }
+    fflush(stdout);
+
+    if (atomic_load_explicit(&log->fatal, memory_order_acquire)) {
+        exit(1);
+    }
+}
+
+static void *log_thread(void *arg) {
+    Log *log = (Log *)arg;
+    while (atomic_load_explicit(&log->running, memory_order_acquire)) {
+        log_drain();
+        struct timespec interval = { 0, LOG_DRAIN_INTERVAL_NS };
+        nanosleep(&interval, NULL);
+    }
+    return NULL;
+}
+
+// a fatal one stops the program as soon as it is printed. without the
+// log thread that happens right here, on the thread that failed. with it
+// the failed thread waits for the log thread to print it and end things,
+// it never goes back to whatever the assert was guarding
+void log_assert(const char *condition, const char *file, int line, bool fatal) {
+    Log *log = &engine_log;
+    if (!fatal) {
+        atomic_fetch_add_explicit(&log->soft_assert_count, 1, memory_order_relaxed);
+    }
+    log_push(fatal ? LOG_LEVEL_FATAL : LOG_LEVEL_ERROR, LOG_CODE_ASSERT, condition, file, line, (double[LOG_ARG_COUNT]){0});
+    if (!fatal) {
+        return;
+    }
+
+    atomic_store_explicit(&log->fatal, true, memory_order_release);
+    if (!log->started) {
+        log_drain();
+    }
+    // log_stop drains once more after the thread is gone, that exits too
+    for (;;) {
+        struct timespec interval = { 0, LOG_DRAIN_INTERVAL_NS };
+        nanosleep(&interval, NULL);
+    }
+}
+
+uint32 get_soft_assert_count() {
+    return atomic_load_explicit(&engine_log.soft_assert_count, memory_order_relaxed);
+}
+
+void log_start() {
+    Log *log = &engine_log;
+    if (log->started) {
+        return;
+    }
+    log->start_ns = log_now();
+    atomic_store(&log->running, true);
+    if (pthread_create(&log->thread, NULL, log_thread, log) != 0) {
+        atomic_store(&log->running, false);
+        return;
+    }
+    log->started = true;
+}
+
+// prints what is left, also without a thread
+void log_stop() {
+    Log *log = &engine_log;
+    if (log->started) {
+        atomic_store(&log->running, false);
+        pthread_join(log->thread, NULL);
+        log->started = false;
+    }
+    log_drain();
+}
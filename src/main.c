@@ -5,23 +5,45 @@ static State *state;
 
 #include "common.c"
 #include "name.c"
+#include "profile.c"
+#include "rt_check.c"
+#include "input.c"
+#include "batch.c"
+#include "font.c"
 #include "file.c"
+#include "mapped_file.c"
 #include "rectangle.c"
-#include "music.c"
+#include "tap.c"
+#include "fft.c"
+#include "wav.c"
+#include "flac.c"
+#include "recorder.c"
+#include "midi_out.c"
+#include "audio.c"
+#include "export.c"
+#include "midi_import.c"
+#include "midi.c"
+#include "midi_in.c"
+#include "snapshot.c"
 #include "select.c"
 #include "render.c"
+#include "headless.c"
 #include "core.c"
 
-int main() {
+int main(int argc, char **argv) {
 
-    init();
+    init(argc, argv);
 
-    while (!WindowShouldClose()) {
+    if (state->headless.enabled) {
+        render_headless();
+    } else {
+        while (!WindowShouldClose() && !input_finished()) {
 
-        update();
+            update();
 
-        render();
+            render();
 
+        }
     }
 
     cleanup();
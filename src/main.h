@@ -1,10 +1,12 @@
-#include <math.h>
-#include <stdlib.h>
-#include <stdint.h>
-
 #include "../raylib/include/raylib.h"
+#include "../raylib/include/rlgl.h"
+
+#include "engine.h"
 
 #define WINDOW_NAME "Triad Practice"
+#define FRAME_RATE 60
+// frames in the audio stream's buffer, what the callback renders ahead
+#define AUDIO_BUFFER_FRAMES 4096
 
 #define TP_BG                               ((Color){0x28, 0x18, 0x10, 0xff})
 #define TP_BG2                              ((Color){0x18, 0x08, 0x00, 0xff})
@@ -19,64 +21,19 @@
 #define COLOR_CURSOR_CURRENT                ((Color){0,255,0,255})
 #define COLOR_CURSOR_SELECTION              ((Color){64,64,64,255})
 
-#define VIBES_PER_CHORD_MIN 1
-#define VIBES_PER_CHORD_MAX 16
-
 #define CHAR_SINGLE_8TH_NOTE    0x266A  // ♪
 #define CHAR_BEAMED_8TH_NOTES   0x266B  // ♫
 #define CHAR_SHARP              0x266F  // ♯
 #define CHAR_FLAT               0x266D  // ♭
 #define CHAR_DIMINISHED         0x00B0  // °
 
-#define INTERVAL_MAJOR_THIRD 4
-#define INTERVAL_MINOR_THIRD 3
-#define INTERVAL_FIFTH 7
-#define INTERVAL_FLAT_FIFTH 6
-#define INTERVAL_AUGMENTED_FIFTH 8
-
-#define SCALE_MAJOR             ((Scale){0, 2, 4, 5, 7, 9, 11})
-#define SCALE_DORIAN            ((Scale){0, 2, 3, 5, 7, 9, 10})
-#define SCALE_PHRYGIAN          ((Scale){0, 1, 3, 5, 7, 8, 10})
-#define SCALE_LYDIAN            ((Scale){0, 2, 4, 6, 7, 9, 11})
-#define SCALE_MIXOLYDIAN        ((Scale){0, 2, 4, 5, 7, 9, 10})
-#define SCALE_MINOR             ((Scale){0, 2, 3, 5, 7, 8, 10})
-#define SCALE_LOCRIAN           ((Scale){0, 1, 3, 5, 6, 8, 10})
-#define SCALE_HARMONIC_MINOR    ((Scale){0, 2, 3, 5, 7, 8, 11})
-#define SCALE_MELODIC_MINOR     ((Scale){0, 2, 3, 5, 7, 9, 11})
-
 #define SELECTABLES_BOX_WIDTH_MULTIPLIER 0.4f
 #define SELECTABLE_ITEM_BG_COLOR_ODD ((Color){48,48,48,255})
 #define SELECTABLE_ITEM_BG_COLOR_EVEN ((Color){64,64,64,255})
 #define SELECTABLE_ITEM_BG_COLOR_SELECTED ((Color){0,0,255,255})
 
 #define CMD_MAX_TEXT 64
-
-typedef int8_t int8;
-typedef uint8_t uint8;
-typedef int16_t int16;
-typedef uint16_t uint16;
-typedef int32_t int32;
-typedef uint32_t uint32;
-typedef int64_t int64;
-typedef uint64_t uint64;
-
-#define SCALE_DEGREE_COUNT 7
-typedef uint8 Scale[SCALE_DEGREE_COUNT];
-
-#define SEQUENCER_AMOUNT 4
-#define SEQUENCER_ROW 8
-#define SEQUENCER_ELEMENTS (SEQUENCER_AMOUNT * SEQUENCER_ROW)
-typedef uint8 Sequencers[SEQUENCER_ELEMENTS];
-
-#define CHORD_NAME_CAPACITY 16
-typedef struct Chord {
-    uint8 root;
-    uint8 third;
-    uint8 fifth;
-    uint8 type;
-    char symbol[CHORD_NAME_CAPACITY];
-    char roman[CHORD_NAME_CAPACITY];
-} Chord;
+#define CMD_MAX_MESSAGE 256
 
 #define MAX_SELECTABLES 16
 typedef struct Selectables {
@@ -87,107 +44,21 @@ typedef struct Selectables {
     uint8 *reference;
 } Selectables;
 
-typedef struct State {
-    uint8 state;
-    uint8 scale_type;
-    uint8 scale_root;
-    uint8 vibe;
-    uint8 vibes_per_chord;
-    AudioStream audio_stream;
-    Font font;
-    int font_spacing;
-    float time_per_chord;
-    float min_time_per_chord;
-    float max_time_per_chord;
-    float chord_timer;
-    int flags;
-    Scale scale;
-    Sequencers sequencer;
-    bool sequencer_states[SEQUENCER_AMOUNT];
-    uint8 sequencer_reps[SEQUENCER_AMOUNT];
-    int chord_idx;
-    float volume_fade;
-    float volume_manual;
-    Selectables selectables;
-    Vector2 mouse_position;
-    char cmd_buffer[CMD_MAX_TEXT];
-    int cmd_cursor;
-} State;
-
 enum {
     STATE_MAIN,
     STATE_SELECT,
     STATE_SAVE_FILE,
+    STATE_LOAD_FILE,
+    STATE_RESTORE,
+    STATE_MESSAGE,
 };
 
 enum {
-    FLAG_PLAYING = (1 << 0),
-    FLAG_FLATS = (1 << 1),
-};
-
-enum {
-    SCALE_DEGREE_I,
-    SCALE_DEGREE_II,
-    SCALE_DEGREE_III,
-    SCALE_DEGREE_IV,
-    SCALE_DEGREE_V,
-    SCALE_DEGREE_VI,
-    SCALE_DEGREE_VII,
-    SCALE_DEGREE_NONE,
+    FLAG_PROFILER = (1 << 0),
+    FLAG_OSCILLOSCOPE = (1 << 1),
+    FLAG_SPECTRUM = (1 << 2),
 };
 
-enum {
-    NOTE_A,
-    NOTE_A_SHARP,
-    NOTE_B_FLAT = NOTE_A_SHARP,
-    NOTE_B,
-    NOTE_C,
-    NOTE_C_SHARP,
-    NOTE_D_FLAT = NOTE_C_SHARP,
-    NOTE_D,
-    NOTE_D_SHARP,
-    NOTE_E_FLAT = NOTE_D_SHARP,
-    NOTE_E,
-    NOTE_F,
-    NOTE_F_SHARP,
-    NOTE_G_FLAT = NOTE_F_SHARP,
-    NOTE_G,
-    NOTE_G_SHARP,
-    NOTE_A_FLAT = NOTE_G_SHARP,
-    NOTE_COUNT,
-};
-
-enum {
-    CHORD_TYPE_NONE,
-    CHORD_TYPE_MAJOR,
-    CHORD_TYPE_MINOR,
-    CHORD_TYPE_DIMINISHED,
-    CHORD_TYPE_AUGMENTED,
-};
-
-enum {
-    SCALE_TYPE_MAJOR,
-    SCALE_TYPE_DORIAN,
-    SCALE_TYPE_PHRYGIAN,
-    SCALE_TYPE_LYDIAN,
-    SCALE_TYPE_MIXOLYDIAN,
-    SCALE_TYPE_MINOR,
-    SCALE_TYPE_LOCRIAN,
-    SCALE_TYPE_HARMONIC_MINOR,
-    SCALE_TYPE_MELODIC_MINOR,
-    SCALE_TYPE_COUNT,
-};
-
-enum {
-    VIBE_POLKA,
-    VIBE_SWING,
-    VIBE_WALTZ,
-    VIBE_CHORD,
-    VIBE_ROOT,
-    VIBE_THIRD,
-    VIBE_FIFTH,
-    VIBE_COUNT,
-};
 
 enum {
     SELECTABLE_TYPE_SCALE_DEGREE,
@@ -201,6 +72,7 @@ enum {
     SEQUENCER_ELEMENT_SECTION_CHORD_SYMBOL,
     SEQUENCER_ELEMENT_SECTION_BUTTON,
     SEQUENCER_ELEMENT_SECTION_CURSOR,
+    SEQUENCER_SECTION_COUNT,
 
     SEQUENCER_STATE_SECTION_RESET = SEQUENCER_ELEMENT_SECTION_BUTTON,
     SEQUENCER_STATE_SECTION_ENABLE = SEQUENCER_ELEMENT_SECTION_CURSOR,
@@ -228,3 +100,383 @@ enum {
     VERTICAL_POSITION_COUNT,
 };
 
+enum {
+    PROFILE_SECTION_UPDATE,
+    PROFILE_SECTION_DRAW_SEQUENCER,
+    PROFILE_SECTION_DRAW_CONTROLS,
+    PROFILE_SECTION_DRAW_OTHER,
+    PROFILE_SECTION_END_DRAWING,
+    PROFILE_SECTION_STACKED_COUNT,
+
+    // nested inside the draw sections so they are not part of the stacked bars
+    PROFILE_SECTION_TEXT = PROFILE_SECTION_STACKED_COUNT,
+    PROFILE_SECTION_FFT,
+    PROFILE_SECTION_COUNT,
+};
+
+#define PROFILE_FRAME_COUNT 240
+#define PROFILE_TRACE_FILE "profile.json"
+
+typedef struct ProfileFrame {
+    double start;
+    double end;
+    double section_start[PROFILE_SECTION_COUNT];
+    double section_time[PROFILE_SECTION_COUNT];
+    // what the frame handed to the gpu, see batch.c
+    uint32 draw_calls;
+    uint32 vertices;
+    uint32 batch_flushes;
+} ProfileFrame;
+
+typedef struct Profiler {
+    ProfileFrame frames[PROFILE_FRAME_COUNT];
+    int frame_idx;
+    int frame_count;
+    double open[PROFILE_SECTION_COUNT];
+} Profiler;
+
+// written only by the audio callback, read by the ui thread,
+// the capacity must stay a power of two
+#define AUDIO_TAP_CAPACITY (1 << 14)
+#define AUDIO_TAP_MASK (AUDIO_TAP_CAPACITY - 1)
+
+typedef struct AudioTap {
+    int16 samples[AUDIO_TAP_CAPACITY];
+    _Atomic uint32 write_idx;
+} AudioTap;
+
+#define OSCILLOSCOPE_WINDOW 2048
+#define OSCILLOSCOPE_SPAN (OSCILLOSCOPE_WINDOW / 2)
+#define OSCILLOSCOPE_POINT_CAPACITY 4096
+
+#define FFT_SIZE 4096
+#define FFT_HALF (FFT_SIZE / 2)
+
+typedef struct Fft {
+    uint16 bitrev[FFT_HALF];
+    float twiddle_re[FFT_HALF];
+    float twiddle_im[FFT_HALF];
+    float split_re[FFT_HALF];
+    float split_im[FFT_HALF];
+    float window[FFT_SIZE];
+    float re[FFT_HALF];
+    float im[FFT_HALF];
+} Fft;
+
+// A2, so spectrum bin k has the pitch class (NOTE_A + k) % NOTE_COUNT
+#define SPECTRUM_LOWEST_FREQ 110.0f
+#define SPECTRUM_BIN_COUNT (NOTE_COUNT * 5)
+#define SPECTRUM_MIN_DB -72.0f
+
+
+#define EXPORT_DIRECTORY "export"
+#define EXPORT_JOB_COUNT (NOTE_COUNT * SCALE_TYPE_COUNT)
+
+// a copy of the progression taken when the export starts,
+// the workers only ever read this
+typedef struct ExportSettings {
+    Sequencers sequencer;
+    bool sequencer_states[SEQUENCER_AMOUNT];
+    uint8 vibe;
+    uint8 vibes_per_chord;
+    float time_per_chord;
+    float cutoff;
+    float resonance;
+    float key_tracking;
+} ExportSettings;
+
+typedef struct Exporter {
+    pthread_t thread;
+    bool started;
+    _Atomic bool running;
+    ExportSettings settings;
+    _Atomic int next_job;
+    _Atomic int done_count;
+    _Atomic int failed_count;
+    _Atomic uint64 frame_count;
+} Exporter;
+
+enum {
+    RECORDING_FORMAT_FLAC,
+    RECORDING_FORMAT_WAV,
+};
+
+// about three seconds, the writer thread comes by a lot more often than that
+#define RECORDER_RING_CAPACITY (1 << 17)
+#define RECORDER_RING_MASK (RECORDER_RING_CAPACITY - 1)
+#define RECORDER_FILE_NAME_CAPACITY 64
+
+// the audio callback pushes into the ring while recording is set,
+// the writer thread pops and encodes. single producer, single consumer
+typedef struct Recorder {
+    int16 ring[RECORDER_RING_CAPACITY];
+    _Atomic uint32 write_idx;
+    _Atomic uint32 read_idx;
+    _Atomic bool recording;
+    _Atomic uint32 dropped;
+    _Atomic uint64 written;
+    pthread_t thread;
+    bool started;
+    uint8 format;
+    char file_name[RECORDER_FILE_NAME_CAPACITY];
+} Recorder;
+
+#define MIDI_VELOCITY 100
+
+enum {
+    MIDI_IMPORT_OK,
+    MIDI_IMPORT_UNREADABLE,
+    MIDI_IMPORT_NOT_MIDI,
+    MIDI_IMPORT_NO_CHORDS,
+};
+
+enum {
+    MIDI_OUT_MODE_OFF,
+    MIDI_OUT_MODE_BOTH,
+    MIDI_OUT_MODE_ONLY,
+    MIDI_OUT_MODE_COUNT,
+};
+
+enum {
+    MIDI_OUT_EVENT_NOTE,
+    MIDI_OUT_EVENT_ANCHOR,
+};
+
+// a block brings an anchor and a handful of notes, this is seconds of them
+#define MIDI_OUT_RING_CAPACITY 4096
+#define MIDI_OUT_RING_MASK (MIDI_OUT_RING_CAPACITY - 1)
+
+// stamped with the audio frame it belongs to, not with when it was sent
+typedef struct MidiOutEvent {
+    uint64 frame;
+    uint8 type;
+    uint8 status;
+    uint8 note;
+    uint8 velocity;
+    // anchors only, the monotonic time the block was rendered at
+    uint64 time;
+} MidiOutEvent;
+
+// the audio callback pushes the notes of every block as it renders it, the
+// sender thread schedules them on the alsa sequencer queue. single producer, single consumer
+typedef struct MidiOut {
+    MidiOutEvent ring[MIDI_OUT_RING_CAPACITY];
+    _Atomic uint32 write_idx;
+    _Atomic uint32 read_idx;
+    _Atomic uint8 mode;
+    _Atomic bool running;
+    _Atomic uint32 dropped;
+    pthread_t thread;
+    bool started;
+    int client;
+    int port;
+} MidiOut;
+
+#define MIDI_IN_RING_CAPACITY 1024
+#define MIDI_IN_RING_MASK (MIDI_IN_RING_CAPACITY - 1)
+#define MIDI_NOTE_COUNT 128
+
+typedef struct MidiInEvent {
+    uint8 status;
+    uint8 note;
+    uint8 velocity;
+} MidiInEvent;
+
+// the input thread pushes note messages, update() pops them and does the
+// chord recognition. single producer, single consumer
+typedef struct MidiIn {
+    MidiInEvent ring[MIDI_IN_RING_CAPACITY];
+    _Atomic uint32 write_idx;
+    _Atomic uint32 read_idx;
+    _Atomic bool running;
+    _Atomic uint32 dropped;
+    pthread_t thread;
+    bool started;
+    int client;
+    int port;
+    // only touched by the ui thread
+    bool held[MIDI_NOTE_COUNT];
+    uint8 held_counts[NOTE_COUNT];
+    uint8 entered_triad;
+} MidiIn;
+
+#define RT_CHECK_MAX_VIOLATIONS 64
+#define RT_CHECK_BACKTRACE_DEPTH 16
+
+enum {
+    RT_VIOLATION_ALLOC,
+    RT_VIOLATION_FREE,
+    RT_VIOLATION_LOCK,
+    RT_VIOLATION_IO,
+    RT_VIOLATION_COUNT,
+};
+
+// written by the audio thread, written is set last so the ui thread
+// never reads a half filled one
+typedef struct RtViolation {
+    _Atomic bool written;
+    uint8 kind;
+    int depth;
+    void *frames[RT_CHECK_BACKTRACE_DEPTH];
+} RtViolation;
+
+typedef struct Layout {
+    int screen_width;
+    int screen_height;
+    float size_multiplier;
+    float font_size;
+    float thing_height;
+    Rectangle load_file;
+    Rectangle save_file;
+    Rectangle play_button;
+    Rectangle cmd;
+    Rectangle sequencer;
+    Rectangle sequencer_state_section;
+    float sequencer_element_width;
+    float sequencer_element_height;
+    Rectangle sequencer_rows[SEQUENCER_AMOUNT];
+    Rectangle sequencer_states[SEQUENCER_AMOUNT];
+    Rectangle sequencer_state_sections[SEQUENCER_AMOUNT][SEQUENCER_SECTION_COUNT];
+    Rectangle sequencer_elements[SEQUENCER_ELEMENTS];
+    Rectangle sequencer_element_sections[SEQUENCER_ELEMENTS][SEQUENCER_SECTION_COUNT];
+    Rectangle controls[CONTROLS_COUNT];
+    Rectangle control_labels[CONTROLS_COUNT];
+    Rectangle control_values[CONTROLS_COUNT];
+} Layout;
+
+// handle is the file descriptor outside windows, where mapping goes unused
+typedef struct MappedFile {
+    void *data;
+    uint32 size;
+    intptr_t handle;
+    intptr_t mapping;
+} MappedFile;
+
+// the part of the session worth getting back after a crash
+typedef struct SnapshotData {
+    uint8 scale_type;
+    uint8 scale_root;
+    uint8 vibe;
+    uint8 vibes_per_chord;
+    bool flats;
+    float time_per_chord;
+    float volume_manual;
+    float filter_cutoff;
+    float filter_resonance;
+    float filter_key_tracking;
+    Sequencers sequencer;
+    bool sequencer_states[SEQUENCER_AMOUNT];
+} SnapshotData;
+
+typedef struct Snapshots {
+    bool started;
+    uint32 sequence;
+    double last_time;
+    SnapshotData last;
+} Snapshots;
+
+#define INPUT_MAX_KEYS 16
+// what the engine renders per frame during a replay, one 60th of a second
+#define INPUT_REPLAY_AUDIO_FRAMES (SAMPLE_RATE / 60)
+#define INPUT_KEY_MASK 0x01ff
+#define INPUT_KEY_PRESSED 0x0200
+#define INPUT_KEY_REPEAT 0x0400
+#define INPUT_KEY_DOWN 0x0800
+
+enum {
+    INPUT_MODE_LIVE,
+    INPUT_MODE_RECORD,
+    INPUT_MODE_REPLAY,
+};
+
+// everything update() reads from the keyboard and mouse in one frame.
+// keys holds only the keys that are down or did something, with flags
+typedef struct InputFrame {
+    Vector2 mouse_position;
+    uint16 screen_width;
+    uint16 screen_height;
+    uint8 mouse_pressed;
+    uint8 key_count;
+    uint16 keys[INPUT_MAX_KEYS];
+} InputFrame;
+
+typedef struct Input {
+    uint8 mode;
+    FILE *file;
+    uint32 frame;
+    bool wrote_frame;
+    InputFrame current;
+    InputFrame previous;
+    // replay reads one frame ahead to know when the next change comes
+    InputFrame next;
+    uint32 next_frame;
+    bool has_next;
+    bool finished;
+    double start_time;
+} Input;
+
+#define TEXT_QUEUE_CAPACITY 512
+#define TEXT_QUEUE_CHARS 16384
+
+// text waiting to be drawn in one go, the strings are copied as most of
+// them come out of TextFormat
+typedef struct QueuedText {
+    int offset;
+    Vector2 position;
+    Vector2 origin;
+    Color color;
+} QueuedText;
+
+typedef struct TextQueue {
+    QueuedText items[TEXT_QUEUE_CAPACITY];
+    int count;
+    char chars[TEXT_QUEUE_CHARS];
+    int char_count;
+} TextQueue;
+
+#define HEADLESS_MAX_SIZES 8
+
+typedef struct Headless {
+    bool enabled;
+    int size_count;
+    int widths[HEADLESS_MAX_SIZES];
+    int heights[HEADLESS_MAX_SIZES];
+    int frame_count;
+    const char *midi_file;
+} Headless;
+
+typedef struct State {
+    uint8 state;
+    Engine engine;
+    AudioStream audio_stream;
+    Font font;
+    Shader font_shader;
+    bool font_is_sdf;
+    int font_spacing;
+    TextQueue text_queue;
+    int flags;
+    uint8 sequencer_reps[SEQUENCER_AMOUNT];
+    Selectables selectables;
+    Vector2 mouse_position;
+    char cmd_buffer[CMD_MAX_TEXT];
+    char cmd_message[CMD_MAX_MESSAGE];
+    int cmd_cursor;
+    Layout layout;
+    Profiler profiler;
+    AudioTap audio_tap;
+    int16 oscilloscope_window[OSCILLOSCOPE_WINDOW];
+    Vector2 oscilloscope_points[OSCILLOSCOPE_POINT_CAPACITY];
+    Fft fft;
+    int16 spectrum_samples[FFT_SIZE];
+    float spectrum_input[FFT_SIZE];
+    float spectrum_power[FFT_HALF + 1];
+    Exporter exporter;
+    Recorder recorder;
+    MidiOut midi_out;
+    MidiIn midi_in;
+    Snapshots snapshots;
+    Input input;
+    Headless headless;
+    // seconds a frame is held for, 0 to draw as fast as it goes
+    double frame_time;
+} State;
@@ -0,0 +1,117 @@
+// a file mapped into memory for reading and writing. stores into it are
+// plain memory writes, the os writes the pages back on its own and flush
+// forces it. flush only makes the one system call, so a crash handler can use it
+
+#ifdef _WIN32
+
+// declared here as windows.h and raylib do not get along
+typedef void *HANDLE;
+__declspec(dllimport) HANDLE __stdcall CreateFileA(const char *name, unsigned long access, unsigned long share, void *security, unsigned long disposition, unsigned long flags, HANDLE template_file);
+__declspec(dllimport) HANDLE __stdcall CreateFileMappingA(HANDLE file, void *security, unsigned long protect, unsigned long size_high, unsigned long size_low, const char *name);
+__declspec(dllimport) void *__stdcall MapViewOfFile(HANDLE mapping, unsigned long access, unsigned long offset_high, unsigned long offset_low, size_t size);
+__declspec(dllimport) int __stdcall FlushViewOfFile(const void *address, size_t size);
+__declspec(dllimport) int __stdcall FlushFileBuffers(HANDLE file);
+__declspec(dllimport) int __stdcall UnmapViewOfFile(const void *address);
+__declspec(dllimport) int __stdcall CloseHandle(HANDLE handle);
+
+#define MAPPED_FILE_GENERIC_READ_WRITE 0xc0000000
+#define MAPPED_FILE_SHARE_READ 0x00000001
+#define MAPPED_FILE_OPEN_ALWAYS 4
+#define MAPPED_FILE_ATTRIBUTE_NORMAL 0x00000080
+#define MAPPED_FILE_PAGE_READWRITE 0x04
+#define MAPPED_FILE_MAP_ALL_ACCESS 0x000f001f
+#define MAPPED_FILE_INVALID_HANDLE ((HANDLE)(intptr_t)-1)
+
+// the mapping grows the file to size when it is shorter
+bool mapped_file_open(MappedFile *file, const char *path, uint32 size) {
+    *file = (MappedFile){0};
+    HANDLE handle = CreateFileA(path, MAPPED_FILE_GENERIC_READ_WRITE, MAPPED_FILE_SHARE_READ, NULL, MAPPED_FILE_OPEN_ALWAYS, MAPPED_FILE_ATTRIBUTE_NORMAL, NULL);
+    if (handle == MAPPED_FILE_INVALID_HANDLE) {
+        return false;
+    }
+    HANDLE mapping = CreateFileMappingA(handle, NULL, MAPPED_FILE_PAGE_READWRITE, 0, size, NULL);
+    if (mapping == NULL) {
+        CloseHandle(handle);
+        return false;
+    }
+    void *data = MapViewOfFile(mapping, MAPPED_FILE_MAP_ALL_ACCESS, 0, 0, size);
+    if (data == NULL) {
+        CloseHandle(mapping);
+        CloseHandle(handle);
+        return false;
+    }
+
+    file->data = data;
+    file->size = size;
+    file->handle = (intptr_t)handle;
+    file->mapping = (intptr_t)mapping;
+    return true;
+}
+
+void mapped_file_flush(MappedFile *file) {
+    if (file->data != NULL) {
+        FlushViewOfFile(file->data, file->size);
+        FlushFileBuffers((HANDLE)file->handle);
+    }
+}
+
+void mapped_file_close(MappedFile *file) {
+    if (file->data == NULL) {
+        return;
+    }
+    mapped_file_flush(file);
+    UnmapViewOfFile(file->data);
+    CloseHandle((HANDLE)file->mapping);
+    CloseHandle((HANDLE)file->handle);
+    *file = (MappedFile){0};
+}
+
+#else
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+bool mapped_file_open(MappedFile *file, const char *path, uint32 size) {
+    *file = (MappedFile){0};
+    int fd = open(path, O_RDWR | O_CREAT, 0644);
+    if (fd < 0) {
+        return false;
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || (info.st_size != size && ftruncate(fd, size) != 0)) {
+        close(fd);
+        return false;
+    }
+
+    void *data = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (data == MAP_FAILED) {
+        close(fd);
+        return false;
+    }
+
+    file->data = data;
+    file->size = size;
+    file->handle = fd;
+    return true;
+}
+
+void mapped_file_flush(MappedFile *file) {
+    if (file->data != NULL) {
+        msync(file->data, file->size, MS_SYNC);
+    }
+}
+
+void mapped_file_close(MappedFile *file) {
+    if (file->data == NULL) {
+        return;
+    }
+    mapped_file_flush(file);
+    munmap(file->data, file->size);
+    close((int)file->handle);
+    *file = (MappedFile){0};
+}
+
+#endif
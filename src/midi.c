@@ -0,0 +1,273 @@
+// standard midi files. export writes type 1: a tempo track and one track per
+// ChordBits voice, with the voicing and step rhythm the synth plays.
+// one vibe is written as a 4/4 bar (the waltz as two bars of 3/4).
+// there is no library of saved progressions to export yet (saving is not
+// in), so the batch export is the progression on screen in every key, the
+// way the wav export does it
+
+#define MIDI_PPQ 480
+#define MIDI_TRACK_COUNT (1 + FREQ_COUNT)
+
+typedef struct MidiBuffer {
+    uint8 *data;
+    uint32 size;
+    uint32 capacity;
+    // out of memory somewhere along the way, nothing after that was written
+    bool failed;
+} MidiBuffer;
+
+static const char *midi_voice_track_names[FREQ_COUNT] = {
+    "root",
+    "third",
+    "fifth",
+    "low fifth",
+};
+
+static void midi_put_bytes(MidiBuffer *buffer, const void *bytes, uint32 count) {
+    if (count == 0 || buffer->failed) {
+        return;
+    }
+    if (buffer->size + count > buffer->capacity) {
+        uint32 capacity = (buffer->capacity > 0) ? buffer->capacity : 4096;
+        while (buffer->size + count > capacity) {
+            capacity *= 2;
+        }
+        uint8 *data = (uint8 *)realloc(buffer->data, capacity);
+        if (data == NULL) {
+            buffer->failed = true;
+            return;
+        }
+        buffer->data = data;
+        buffer->capacity = capacity;
+    }
+    memcpy(buffer->data + buffer->size, bytes, count);
+    buffer->size += count;
+}
+
+static void midi_put_u8(MidiBuffer *buffer, uint8 value) {
+    midi_put_bytes(buffer, &value, 1);
+}
+
+static void midi_put_u16(MidiBuffer *buffer, uint16 value) {
+    uint8 bytes[2] = { value >> 8, value & 0xff };
+    midi_put_bytes(buffer, bytes, 2);
+}
+
+static void midi_put_u32(MidiBuffer *buffer, uint32 value) {
+    uint8 bytes[4] = { value >> 24, (value >> 16) & 0xff, (value >> 8) & 0xff, value & 0xff };
+    midi_put_bytes(buffer, bytes, 4);
+}
+
+static void midi_put_variable(MidiBuffer *buffer, uint32 value) {
+    uint8 bytes[5];
+    int count = 0;
+    bytes[count++] = value & 0x7f;
+    while ((value >>= 7) > 0) {
+        bytes[count++] = 0x80 | (value & 0x7f);
+    }
+    while (count > 0) {
+        midi_put_u8(buffer, bytes[--count]);
+    }
+}
+
+static void midi_put_meta(MidiBuffer *buffer, uint32 delta, uint8 type, const void *bytes, uint32 count) {
+    midi_put_variable(buffer, delta);
+    midi_put_u8(buffer, 0xff);
+    midi_put_u8(buffer, type);
+    midi_put_variable(buffer, count);
+    midi_put_bytes(buffer, bytes, count);
+}
+
+// returns where the length goes, patched by midi_end_track()
+static uint32 midi_begin_track(MidiBuffer *buffer, const char *name) {
+    midi_put_bytes(buffer, "MTrk", 4);
+    uint32 length_offset = buffer->size;
+    midi_put_u32(buffer, 0);
+    midi_put_meta(buffer, 0, 0x03, name, strlen(name));
+    return length_offset;
+}
+
+static void midi_end_track(MidiBuffer *buffer, uint32 length_offset) {
+    midi_put_meta(buffer, 0, 0x2f, NULL, 0);
+    if (buffer->failed) {
+        return;
+    }
+    uint32 length = buffer->size - length_offset - 4;
+    uint8 *p = buffer->data + length_offset;
+    p[0] = length >> 24;
+    p[1] = (length >> 16) & 0xff;
+    p[2] = (length >> 8) & 0xff;
+    p[3] = length & 0xff;
+}
+
+inline static uint32 midi_get_ticks(double seconds, double seconds_per_quarter) {
+    return (uint32)(seconds / seconds_per_quarter * MIDI_PPQ + 0.5);
+}
+
+// one voice of the progression, the notes follow the vibe steps like the
+// synth does: a step plays from its start until it (or the vibe) ends
+static void midi_put_voice_track(MidiBuffer *buffer, const ExportSettings *settings, const uint8 *scale, uint8 scale_root, int voice, double seconds_per_quarter) {
+    uint32 length_offset = midi_begin_track(buffer, midi_voice_track_names[voice]);
+
+    VibeStep steps[16];
+    float fract;
+    int step_count = get_vibe_steps(settings->vibe, settings->time_per_chord, settings->vibes_per_chord, steps, &fract);
+    double range = (double)settings->time_per_chord / settings->vibes_per_chord;
+    uint8 channel = voice;
+
+    uint32 now = 0;
+    double chord_start = 0.0;
+    for (int i = 0; i < SEQUENCER_ELEMENTS; i++) {
+        if (!settings->sequencer_states[i / SEQUENCER_ROW]) {
+            continue;
+        }
+        Chord chord = make_chord(scale, scale_root, settings->sequencer[i]);
+        if (chord.type == CHORD_TYPE_NONE) {
+            continue;
+        }
+
+        int notes[FREQ_COUNT];
+        get_chord_voicing(chord.root, chord.third, chord.fifth, settings->vibe, notes);
+
+        for (int rep = 0; rep < settings->vibes_per_chord; rep++) {
+            double vibe_start = chord_start + rep * range;
+            for (int j = 0; j < step_count; j++) {
+                double step_start = steps[j].start * fract;
+                double step_end = steps[j].end * fract;
+                if ((steps[j].bits & (1 << voice)) == 0 || step_start >= range) {
+                    continue;
+                }
+                if (step_end > range) {
+                    step_end = range;
+                }
+
+                uint32 on = midi_get_ticks(vibe_start + step_start, seconds_per_quarter);
+                uint32 off = midi_get_ticks(vibe_start + step_end, seconds_per_quarter);
+                uint8 note_on[3] = { 0x90 | channel, notes[voice], MIDI_VELOCITY };
+                uint8 note_off[3] = { 0x80 | channel, notes[voice], 0 };
+
+                midi_put_variable(buffer, on - now);
+                midi_put_bytes(buffer, note_on, 3);
+                midi_put_variable(buffer, off - on);
+                midi_put_bytes(buffer, note_off, 3);
+                now = off;
+            }
+        }
+        chord_start += settings->time_per_chord;
+    }
+
+    midi_end_track(buffer, length_offset);
+}
+
+bool export_midi_file(const ExportSettings *settings, uint8 scale_root, uint8 scale_type, const char *file_name) {
+    Scale scale;
+    get_scale(scale_type, scale);
+
+    bool waltz = settings->vibe == VIBE_WALTZ;
+    double range = (double)settings->time_per_chord / settings->vibes_per_chord;
+    double seconds_per_quarter = range / (waltz ? 6.0 : 4.0);
+
+    MidiBuffer buffer = {0};
+
+    midi_put_bytes(&buffer, "MThd", 4);
+    midi_put_u32(&buffer, 6);
+    midi_put_u16(&buffer, 1);
+    midi_put_u16(&buffer, MIDI_TRACK_COUNT);
+    midi_put_u16(&buffer, MIDI_PPQ);
+
+    uint32 length_offset = midi_begin_track(&buffer, WINDOW_NAME);
+    uint32 tempo = (uint32)(seconds_per_quarter * 1000000.0 + 0.5);
+    uint8 tempo_bytes[3] = { tempo >> 16, (tempo >> 8) & 0xff, tempo & 0xff };
+    midi_put_meta(&buffer, 0, 0x51, tempo_bytes, 3);
+    uint8 time_signature[4] = { waltz ? 3 : 4, 2, 24, 8 };
+    midi_put_meta(&buffer, 0, 0x58, time_signature, 4);
+    midi_end_track(&buffer, length_offset);
+
+    for (int voice = 0; voice < FREQ_COUNT; voice++) {
+        midi_put_voice_track(&buffer, settings, scale, scale_root, voice, seconds_per_quarter);
+    }
+
+    bool ok = false;
+    FILE *file = buffer.failed ? NULL : fopen(file_name, "wb");
+    if (file != NULL) {
+        ok = fwrite(buffer.data, 1, buffer.size, file) == buffer.size;
+        ok = (fclose(file) == 0) && ok;
+    }
+    free(buffer.data);
+    return ok;
+}
+
+// the current key, or with all_keys every root and scale type like the wav export
+void export_midi(bool all_keys) {
+    if (!is_sequencer_active(&state->engine)) {
+        return;
+    }
+
+    ExportSettings settings;
+    get_export_settings(&settings);
+    MakeDirectory(EXPORT_DIRECTORY);
+
+    int first = all_keys ? 0 : (state->engine.scale_type * NOTE_COUNT) + state->engine.scale_root;
+    int last = all_keys ? EXPORT_JOB_COUNT : first + 1;
+    int failed = 0;
+
+    double start = get_wall_time();
+    for (int job = first; job < last; job++) {
+        char file_name[EXPORT_FILE_NAME_CAPACITY];
+        snprintf(
+            file_name,
+            EXPORT_FILE_NAME_CAPACITY,
+            "%s/%s_%s.mid",
+            EXPORT_DIRECTORY,
+            get_note_file_name(job % NOTE_COUNT),
+            get_scale_file_name(job / NOTE_COUNT)
+        );
+        if (!export_midi_file(&settings, job % NOTE_COUNT, job / NOTE_COUNT, file_name)) {
+            printf("export: could not write %s\n", file_name);
+            failed++;
+        }
+    }
+    printf("export: %d midi files (%d failed) in %.1fms\n", last - first, failed, (get_wall_time() - start) * 1000.0);
+}
+
+// fills the sequencer from the file and switches to the key that fits it best,
+// nothing changes unless it comes back MIDI_IMPORT_OK
+uint8 import_midi(const char *file_name) {
+    int size = 0;
+    uint8 *data = LoadFileData(file_name, &size);
+    if (data == NULL) {
+        return MIDI_IMPORT_UNREADABLE;
+    }
+
+    Chord chords[SEQUENCER_ELEMENTS];
+    int chord_count = midi_read_chords(data, size, chords, SEQUENCER_ELEMENTS);
+    UnloadFileData(data);
+    if (chord_count < 0) {
+        return MIDI_IMPORT_NOT_MIDI;
+    }
+    if (chord_count == 0) {
+        return MIDI_IMPORT_NO_CHORDS;
+    }
+
+    midi_find_key(chords, chord_count, &state->engine.scale_root, &state->engine.scale_type);
+    refresh_scale(&state->engine);
+
+    int filled = 0;
+    for (int i = 0; i < chord_count; i++) {
+        int degree = midi_get_scale_degree(state->engine.scale, state->engine.scale_root, chords[i]);
+        // chords from outside the key have no cell to go in
+        if (degree != SCALE_DEGREE_NONE) {
+            state->engine.sequencer[filled++] = degree;
+        }
+    }
+    for (int i = filled; i < SEQUENCER_ELEMENTS; i++) {
+        state->engine.sequencer[i] = SCALE_DEGREE_NONE;
+    }
+    for (int i = 0; i < SEQUENCER_AMOUNT; i++) {
+        state->engine.sequencer_states[i] = (i * SEQUENCER_ROW) < filled;
+    }
+
+    state->engine.chord_idx = 0;
+    state->engine.chord_timer = 0.0f;
+    return MIDI_IMPORT_OK;
+}
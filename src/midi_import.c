@@ -0,0 +1,304 @@
+// import reads every track in place and merges them by time, one cursor per
+// track, so no event list is ever built. the notes that start on the same
+// tick are one chord event, looked up as a pitch class set once the whole
+// tick has been read
+
+#define MIDI_IMPORT_MAX_TRACKS 64
+#define MIDI_DRUM_CHANNEL 9
+#define MIDI_TRIAD_NONE 0xff
+
+typedef struct MidiTrackCursor {
+    const uint8 *p;
+    const uint8 *end;
+    uint32 tick;
+    uint8 running_status;
+    bool done;
+} MidiTrackCursor;
+
+// pitch class set (bit n is NOTE_A + n) -> root << 3 | chord type
+static uint8 midi_triads[1 << NOTE_COUNT];
+static bool midi_triads_ready = false;
+
+static void midi_build_triads() {
+    static const uint8 intervals[][3] = {
+        [CHORD_TYPE_MAJOR] = { 0, INTERVAL_MAJOR_THIRD, INTERVAL_FIFTH },
+        [CHORD_TYPE_MINOR] = { 0, INTERVAL_MINOR_THIRD, INTERVAL_FIFTH },
+        [CHORD_TYPE_DIMINISHED] = { 0, INTERVAL_MINOR_THIRD, INTERVAL_FLAT_FIFTH },
+        [CHORD_TYPE_AUGMENTED] = { 0, INTERVAL_MAJOR_THIRD, INTERVAL_AUGMENTED_FIFTH },
+    };
+
+    memset(midi_triads, MIDI_TRIAD_NONE, sizeof(midi_triads));
+    for (int type = CHORD_TYPE_MAJOR; type <= CHORD_TYPE_AUGMENTED; type++) {
+        for (int root = 0; root < NOTE_COUNT; root++) {
+            uint32 set = 0;
+            for (int i = 0; i < 3; i++) {
+                set |= 1 << ((root + intervals[type][i]) % NOTE_COUNT);
+            }
+            // augmented triads are symmetric, the first root wins
+            if (midi_triads[set] == MIDI_TRIAD_NONE) {
+                midi_triads[set] = (root << 3) | type;
+            }
+        }
+    }
+    midi_triads_ready = true;
+}
+
+static bool midi_get_variable(const uint8 **p, const uint8 *end, uint32 *value) {
+    *value = 0;
+    for (int i = 0; i < 4; i++) {
+        if (*p >= end) {
+            return false;
+        }
+        uint8 byte = *(*p)++;
+        *value = (*value << 7) | (byte & 0x7f);
+        if ((byte & 0x80) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static uint32 midi_get_u32(const uint8 *p) {
+    return ((uint32)p[0] << 24) | ((uint32)p[1] << 16) | ((uint32)p[2] << 8) | p[3];
+}
+
+static void midi_cursor_read_delta(MidiTrackCursor *cursor) {
+    uint32 delta;
+    if (cursor->p >= cursor->end || !midi_get_variable(&cursor->p, cursor->end, &delta)) {
+        cursor->done = true;
+        return;
+    }
+    cursor->tick += delta;
+}
+
+// steps over one event, returns the pitch class of a note on or off and
+// which one it was, or -1
+static int midi_cursor_next_event(MidiTrackCursor *cursor, bool *note_on) {
+    const uint8 *end = cursor->end;
+    int pitch_class = -1;
+
+    if (cursor->p >= end) {
+        cursor->done = true;
+        return -1;
+    }
+
+    uint8 status = *cursor->p;
+    if (status & 0x80) {
+        cursor->p++;
+    } else {
+        status = cursor->running_status;
+    }
+
+    if (status == 0xff) {
+        // type byte, then the length of the data
+        uint32 length;
+        if (cursor->p >= end) {
+            cursor->done = true;
+            return -1;
+        }
+        cursor->p++;
+        if (!midi_get_variable(&cursor->p, end, &length) || length > (uint32)(end - cursor->p)) {
+            cursor->done = true;
+            return -1;
+        }
+        cursor->p += length;
+    } else if (status == 0xf0 || status == 0xf7) {
+        uint32 length;
+        if (!midi_get_variable(&cursor->p, end, &length) || length > (uint32)(end - cursor->p)) {
+            cursor->done = true;
+            return -1;
+        }
+        cursor->p += length;
+    } else if (status & 0x80) {
+        cursor->running_status = status;
+        uint8 kind = status & 0xf0;
+        int data_count = (kind == 0xc0 || kind == 0xd0) ? 1 : 2;
+        if (end - cursor->p < data_count) {
+            cursor->done = true;
+            return -1;
+        }
+        uint8 note = cursor->p[0];
+        uint8 velocity = (data_count > 1) ? cursor->p[1] : 0;
+        cursor->p += data_count;
+
+        bool is_note = kind == 0x80 || kind == 0x90;
+        if (is_note && (status & 0x0f) != MIDI_DRUM_CHANNEL) {
+            pitch_class = (note + NOTE_COUNT * 10 - MIDI_NOTE_A4) % NOTE_COUNT;
+            *note_on = kind == 0x90 && velocity > 0;
+        }
+    } else {
+        // data byte without any status to run on
+        cursor->done = true;
+        return -1;
+    }
+
+    midi_cursor_read_delta(cursor);
+    return pitch_class;
+}
+
+static int midi_popcount(uint32 set) {
+    int count = 0;
+    while (set) {
+        set &= set - 1;
+        count++;
+    }
+    return count;
+}
+
+// every chord struck in the file in order, one per chord event, so a chord
+// played twice in a row is two of them.
+// returns -1 if this is not a midi file
+static int midi_read_chords(const uint8 *data, uint32 size, Chord *chords, int capacity) {
+    if (size < 14 || memcmp(data, "MThd", 4) != 0) {
+        return -1;
+    }
+    // checked before it goes anywhere near a pointer
+    uint32 header_length = midi_get_u32(data + 4);
+    if (header_length < 6 || header_length > size - 8) {
+        return -1;
+    }
+    const uint8 *p = data + 8 + header_length;
+    const uint8 *end = data + size;
+
+    MidiTrackCursor cursors[MIDI_IMPORT_MAX_TRACKS];
+    int track_count = 0;
+    while (end - p >= 8 && track_count < MIDI_IMPORT_MAX_TRACKS) {
+        uint32 length = midi_get_u32(p + 4);
+        const uint8 *chunk = p + 8;
+        if (length > (uint32)(end - chunk)) {
+            length = end - chunk;
+        }
+        if (memcmp(p, "MTrk", 4) == 0) {
+            MidiTrackCursor *cursor = &cursors[track_count++];
+            *cursor = (MidiTrackCursor){ .p = chunk, .end = chunk + length };
+            midi_cursor_read_delta(cursor);
+        }
+        p = chunk + length;
+    }
+
+    if (!midi_triads_ready) {
+        midi_build_triads();
+    }
+
+    int chord_count = 0;
+    uint8 prev_triad = MIDI_TRIAD_NONE;
+    // how many of each pitch class are sounding
+    uint8 held[NOTE_COUNT] = {0};
+    // notes since the last chord, for chords played one note at a time
+    uint32 pending = 0;
+
+    for (;;) {
+        uint32 tick = 0;
+        bool any = false;
+        for (int i = 0; i < track_count; i++) {
+            if (!cursors[i].done && (!any || cursors[i].tick < tick)) {
+                tick = cursors[i].tick;
+                any = true;
+            }
+        }
+        if (!any) {
+            break;
+        }
+
+        // every event on this tick from every track, note offs included so
+        // a chord that ends where the next one starts is not held into it
+        uint32 onsets = 0;
+        for (int i = 0; i < track_count; i++) {
+            MidiTrackCursor *cursor = &cursors[i];
+            while (!cursor->done && cursor->tick == tick) {
+                bool note_on = false;
+                int pitch_class = midi_cursor_next_event(cursor, &note_on);
+                if (pitch_class < 0) {
+                    continue;
+                }
+                if (note_on) {
+                    onsets |= 1 << pitch_class;
+                    if (held[pitch_class] < 0xff) {
+                        held[pitch_class]++;
+                    }
+                } else if (held[pitch_class] > 0) {
+                    held[pitch_class]--;
+                }
+            }
+        }
+        if (onsets == 0) {
+            continue;
+        }
+
+        uint32 sounding = 0;
+        for (int i = 0; i < NOTE_COUNT; i++) {
+            if (held[i] > 0) {
+                sounding |= 1 << i;
+            }
+        }
+
+        // what was struck together, then that with what is still held,
+        // then everything since the last chord. only the one found through
+        // held notes can be the chord before still ringing, with a melody
+        // note over it, every other one was struck anew
+        pending |= onsets;
+        bool struck = true;
+        uint8 triad = midi_triads[onsets];
+        if (triad == MIDI_TRIAD_NONE) {
+            triad = midi_triads[sounding];
+            struck = false;
+        }
+        if (triad == MIDI_TRIAD_NONE) {
+            triad = midi_triads[pending];
+            struck = true;
+        }
+
+        if (triad != MIDI_TRIAD_NONE) {
+            if ((struck || triad != prev_triad) && chord_count < capacity) {
+                chords[chord_count++] = (Chord){ .root = triad >> 3, .type = triad & 7 };
+            }
+            prev_triad = triad;
+            pending = 0;
+        } else if (midi_popcount(pending) > 3) {
+            // passing notes, start over from this tick
+            pending = onsets;
+        }
+    }
+
+    return chord_count;
+}
+
+static int midi_get_scale_degree(const uint8 *scale, uint8 scale_root, Chord chord) {
+    for (int degree = 0; degree < SCALE_DEGREE_COUNT; degree++) {
+        Chord candidate = make_chord(scale, scale_root, degree);
+        if (candidate.root == chord.root && candidate.type == chord.type) {
+            return degree;
+        }
+    }
+    return SCALE_DEGREE_NONE;
+}
+
+// the scale with the most chords in it, then the one that starts
+// and ends on its tonic, then the more common scale type
+static void midi_find_key(const Chord *chords, int chord_count, uint8 *scale_root, uint8 *scale_type) {
+    int best_score = -1;
+    for (int type = 0; type < SCALE_TYPE_COUNT; type++) {
+        Scale scale;
+        get_scale(type, scale);
+        for (int root = 0; root < NOTE_COUNT; root++) {
+            int score = 0;
+            for (int i = 0; i < chord_count; i++) {
+                if (midi_get_scale_degree(scale, root, chords[i]) != SCALE_DEGREE_NONE) {
+                    score += 4;
+                }
+            }
+            if (midi_get_scale_degree(scale, root, chords[0]) == SCALE_DEGREE_I) {
+                score += 2;
+            }
+            if (midi_get_scale_degree(scale, root, chords[chord_count - 1]) == SCALE_DEGREE_I) {
+                score += 1;
+            }
+            if (score > best_score) {
+                best_score = score;
+                *scale_root = root;
+                *scale_type = type;
+            }
+        }
+    }
+}
+
@@ -0,0 +1,262 @@
+#ifdef __linux__
+    #include <alsa/asoundlib.h>
+    #include <poll.h>
+#endif
+
+// step entry from a midi keyboard. play a triad and it goes into the cell
+// under the sequencer cursor, then the cursor moves on. the notes come in on
+// their own thread and are only queued there, update() drains the queue and
+// looks the held pitch classes up in the same triad table the file import uses
+
+#define MIDI_IN_POLL_TIMEOUT_MS 100
+
+static void midi_in_push(MidiIn *midi_in, MidiInEvent event) {
+    uint32 write_idx = atomic_load_explicit(&midi_in->write_idx, memory_order_relaxed);
+    uint32 read_idx = atomic_load_explicit(&midi_in->read_idx, memory_order_acquire);
+    if (write_idx - read_idx >= MIDI_IN_RING_CAPACITY) {
+        atomic_fetch_add_explicit(&midi_in->dropped, 1, memory_order_relaxed);
+        return;
+    }
+    midi_in->ring[write_idx & MIDI_IN_RING_MASK] = event;
+    atomic_store_explicit(&midi_in->write_idx, write_idx + 1, memory_order_release);
+}
+
+static bool midi_in_pop(MidiIn *midi_in, MidiInEvent *event) {
+    uint32 read_idx = atomic_load_explicit(&midi_in->read_idx, memory_order_relaxed);
+    uint32 write_idx = atomic_load_explicit(&midi_in->write_idx, memory_order_acquire);
+    if (read_idx == write_idx) {
+        return false;
+    }
+    *event = midi_in->ring[read_idx & MIDI_IN_RING_MASK];
+    atomic_store_explicit(&midi_in->read_idx, read_idx + 1, memory_order_release);
+    return true;
+}
+
+#if defined(__linux__)
+
+static snd_seq_t *midi_in_seq;
+
+static bool midi_in_open(MidiIn *midi_in) {
+    if (snd_seq_open(&midi_in_seq, "default", SND_SEQ_OPEN_INPUT, SND_SEQ_NONBLOCK) < 0) {
+        return false;
+    }
+    snd_seq_set_client_name(midi_in_seq, WINDOW_NAME);
+
+    midi_in->port = snd_seq_create_simple_port(
+        midi_in_seq,
+        "keyboard",
+        SND_SEQ_PORT_CAP_WRITE | SND_SEQ_PORT_CAP_SUBS_WRITE,
+        SND_SEQ_PORT_TYPE_MIDI_GENERIC | SND_SEQ_PORT_TYPE_APPLICATION
+    );
+    if (midi_in->port < 0) {
+        snd_seq_close(midi_in_seq);
+        return false;
+    }
+    midi_in->client = snd_seq_client_id(midi_in_seq);
+    return true;
+}
+
+static void midi_in_close() {
+    snd_seq_close(midi_in_seq);
+    midi_in_seq = NULL;
+}
+
+// wakes up now and then even without input to see if it should stop
+static void *midi_in_thread(void *arg) {
+    MidiIn *midi_in = (MidiIn *)arg;
+
+    struct pollfd fds[4];
+    int fd_count = snd_seq_poll_descriptors_count(midi_in_seq, POLLIN);
+    if (fd_count > 4) {
+        fd_count = 4;
+    }
+    snd_seq_poll_descriptors(midi_in_seq, fds, fd_count, POLLIN);
+
+    while (atomic_load_explicit(&midi_in->running, memory_order_acquire)) {
+        if (poll(fds, fd_count, MIDI_IN_POLL_TIMEOUT_MS) <= 0) {
+            continue;
+        }
+
+        snd_seq_event_t *ev;
+        while (snd_seq_event_input(midi_in_seq, &ev) >= 0) {
+            if (ev->type == SND_SEQ_EVENT_NOTEON) {
+                midi_in_push(midi_in, (MidiInEvent){ 0x90 | ev->data.note.channel, ev->data.note.note, ev->data.note.velocity });
+            } else if (ev->type == SND_SEQ_EVENT_NOTEOFF) {
+                midi_in_push(midi_in, (MidiInEvent){ 0x80 | ev->data.note.channel, ev->data.note.note, 0 });
+            }
+        }
+    }
+    return NULL;
+}
+
+#elif defined(_WIN32)
+
+// winmm already hands the messages over on a thread of its own, the callback
+// only queues them. declared here as windows.h and raylib do not get along
+typedef void *HMIDIIN;
+__declspec(dllimport) unsigned int __stdcall midiInGetNumDevs(void);
+__declspec(dllimport) unsigned int __stdcall midiInOpen(HMIDIIN *handle, unsigned int device, uintptr_t callback, uintptr_t instance, unsigned long flags);
+__declspec(dllimport) unsigned int __stdcall midiInStart(HMIDIIN handle);
+__declspec(dllimport) unsigned int __stdcall midiInStop(HMIDIIN handle);
+__declspec(dllimport) unsigned int __stdcall midiInClose(HMIDIIN handle);
+
+#define MIDI_IN_CALLBACK_FUNCTION 0x00030000
+#define MIDI_IN_MIM_DATA 0x3c3
+
+static HMIDIIN midi_in_handle;
+
+static void __stdcall midi_in_callback(HMIDIIN handle, unsigned int message, uintptr_t instance, uintptr_t param1, uintptr_t param2) {
+    if (message != MIDI_IN_MIM_DATA) {
+        return;
+    }
+    MidiIn *midi_in = (MidiIn *)instance;
+    uint8 status = param1 & 0xff;
+    uint8 kind = status & 0xf0;
+    if (kind == 0x90 || kind == 0x80) {
+        midi_in_push(midi_in, (MidiInEvent){ status, (param1 >> 8) & 0x7f, (param1 >> 16) & 0x7f });
+    }
+}
+
+// the first input device, there is no picking one yet
+static bool midi_in_open(MidiIn *midi_in) {
+    if (midiInGetNumDevs() == 0) {
+        return false;
+    }
+    if (midiInOpen(&midi_in_handle, 0, (uintptr_t)midi_in_callback, (uintptr_t)midi_in, MIDI_IN_CALLBACK_FUNCTION) != 0) {
+        return false;
+    }
+    midiInStart(midi_in_handle);
+    midi_in->client = 0;
+    midi_in->port = 0;
+    return true;
+}
+
+static void midi_in_close() {
+    midiInStop(midi_in_handle);
+    midiInClose(midi_in_handle);
+    midi_in_handle = NULL;
+}
+
+static void *midi_in_thread(void *arg) {
+    return NULL;
+}
+
+#else
+
+static bool midi_in_open(MidiIn *midi_in) {
+    return false;
+}
+
+static void midi_in_close() {
+}
+
+static void *midi_in_thread(void *arg) {
+    return NULL;
+}
+
+#endif
+
+static void midi_in_start(MidiIn *midi_in) {
+    memset(midi_in->held, 0, sizeof(midi_in->held));
+    memset(midi_in->held_counts, 0, sizeof(midi_in->held_counts));
+    midi_in->entered_triad = MIDI_TRIAD_NONE;
+    atomic_store(&midi_in->read_idx, atomic_load(&midi_in->write_idx));
+    atomic_store(&midi_in->dropped, 0);
+
+    if (!midi_in_open(midi_in)) {
+        printf("midi in: no midi input to open\n");
+        return;
+    }
+
+    atomic_store(&midi_in->running, true);
+#ifdef __linux__
+    if (pthread_create(&midi_in->thread, NULL, midi_in_thread, midi_in) != 0) {
+        atomic_store(&midi_in->running, false);
+        midi_in_close();
+        return;
+    }
+#endif
+
+    midi_in->started = true;
+    printf("midi in: listening on port %i:%i\n", midi_in->client, midi_in->port);
+}
+
+void stop_midi_in() {
+    MidiIn *midi_in = &state->midi_in;
+    if (!midi_in->started) {
+        return;
+    }
+
+    atomic_store(&midi_in->running, false);
+#ifdef __linux__
+    pthread_join(midi_in->thread, NULL);
+#endif
+    midi_in_close();
+    midi_in->started = false;
+}
+
+void toggle_midi_in() {
+    if (state->midi_in.started) {
+        stop_midi_in();
+    } else {
+        midi_in_start(&state->midi_in);
+    }
+}
+
+static void midi_in_enter_triad(uint8 triad) {
+    Chord chord = { .root = triad >> 3, .type = triad & 7 };
+    int degree = midi_get_scale_degree(state->engine.scale, state->engine.scale_root, chord);
+    // chords from outside the key have no cell to go in
+    if (degree == SCALE_DEGREE_NONE) {
+        return;
+    }
+
+    int idx = state->engine.chord_idx;
+    state->engine.sequencer[idx] = degree;
+    state->engine.sequencer_states[idx / SEQUENCER_ROW] = true;
+    state->engine.chord_idx = (idx + 1) % SEQUENCER_ELEMENTS;
+    state->engine.chord_timer = 0.0f;
+}
+
+// a chord is entered once while it is held, letting go of every key or
+// moving to a different triad allows the next one
+void midi_in_update() {
+    MidiIn *midi_in = &state->midi_in;
+    if (!midi_in->started) {
+        return;
+    }
+    if (!midi_triads_ready) {
+        midi_build_triads();
+    }
+
+    MidiInEvent event;
+    while (midi_in_pop(midi_in, &event)) {
+        uint8 kind = event.status & 0xf0;
+        uint8 note = event.note & 0x7f;
+        uint8 pitch_class = (note + NOTE_COUNT * 10 - MIDI_NOTE_A4) % NOTE_COUNT;
+        bool on = kind == 0x90 && event.velocity > 0;
+
+        if ((event.status & 0x0f) == MIDI_DRUM_CHANNEL || midi_in->held[note] == on) {
+            continue;
+        }
+        midi_in->held[note] = on;
+        midi_in->held_counts[pitch_class] += on ? 1 : -1;
+
+        uint32 set = 0;
+        for (int i = 0; i < NOTE_COUNT; i++) {
+            if (midi_in->held_counts[i] > 0) {
+                set |= 1 << i;
+            }
+        }
+
+        if (set == 0) {
+            midi_in->entered_triad = MIDI_TRIAD_NONE;
+        } else if (on) {
+            uint8 triad = midi_triads[set];
+            if (triad != MIDI_TRIAD_NONE && triad != midi_in->entered_triad) {
+                midi_in_enter_triad(triad);
+                midi_in->entered_triad = triad;
+            }
+        }
+    }
+}
@@ -0,0 +1,372 @@
+#include <time.h>
+#ifdef __linux__
+    #include <alsa/asoundlib.h>
+#endif
+
+// plays the progression on an alsa sequencer port, next to or instead of the
+// synth. the audio callback knows to the frame where every step of a chord
+// starts and ends, so it pushes the notes of each block as it renders it,
+// stamped with audio frames. the sender thread puts them on a sequencer queue
+// as far behind as the audio output runs, so when they come out does not
+// depend on when the thread or the ui get to run, and whatever the transport
+// does next (a click on the sequencer, an edited cell, a new tempo) is never
+// more than a block away from the external synth.
+// to try it without hardware: modprobe snd-virmidi, aconnect the port to it
+// and watch the other end with aseqdump
+
+// a block is rendered while the one before it is still in the stream buffer,
+// and the device holds a period on top of that. raylib does not say which
+// period it got, this is miniaudio's default
+#define MIDI_OUT_DEVICE_PERIOD_NS 10000000
+#define MIDI_OUT_LATENCY_NS ((uint64)AUDIO_BUFFER_FRAMES * 1000000000 / SAMPLE_RATE + MIDI_OUT_DEVICE_PERIOD_NS)
+#define MIDI_OUT_POLL_INTERVAL_NS 5000000
+#define MIDI_OUT_CONTROLLER_ALL_NOTES_OFF 123
+// room on the kernel side for the events of a few blocks
+#define MIDI_OUT_POOL_SIZE 2000
+
+// only touched by the audio thread, the note each voice channel is holding
+static bool midi_out_holding[FREQ_COUNT];
+static uint8 midi_out_notes[FREQ_COUNT];
+
+#ifdef __linux__
+static snd_seq_t *midi_out_seq;
+static int midi_out_queue;
+#endif
+
+static uint64 midi_out_now() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static void midi_out_push(MidiOut *midi_out, MidiOutEvent event) {
+    uint32 write_idx = atomic_load_explicit(&midi_out->write_idx, memory_order_relaxed);
+    uint32 read_idx = atomic_load_explicit(&midi_out->read_idx, memory_order_acquire);
+    if (write_idx - read_idx >= MIDI_OUT_RING_CAPACITY) {
+        atomic_fetch_add_explicit(&midi_out->dropped, 1, memory_order_relaxed);
+        return;
+    }
+    midi_out->ring[write_idx & MIDI_OUT_RING_MASK] = event;
+    atomic_store_explicit(&midi_out->write_idx, write_idx + 1, memory_order_release);
+}
+
+static bool midi_out_pop(MidiOut *midi_out, MidiOutEvent *event) {
+    uint32 read_idx = atomic_load_explicit(&midi_out->read_idx, memory_order_relaxed);
+    uint32 write_idx = atomic_load_explicit(&midi_out->write_idx, memory_order_acquire);
+    if (read_idx == write_idx) {
+        return false;
+    }
+    *event = midi_out->ring[read_idx & MIDI_OUT_RING_MASK];
+    atomic_store_explicit(&midi_out->read_idx, read_idx + 1, memory_order_release);
+    return true;
+}
+
+static void midi_out_note_off(MidiOut *midi_out, uint64 frame, int voice) {
+    if (midi_out_holding[voice]) {
+        midi_out_push(midi_out, (MidiOutEvent){ frame, MIDI_OUT_EVENT_NOTE, 0x80 | voice, midi_out_notes[voice], 0 });
+        midi_out_holding[voice] = false;
+    }
+}
+
+static void midi_out_note_on(MidiOut *midi_out, uint64 frame, int voice, uint8 note) {
+    midi_out_note_off(midi_out, frame, voice);
+    midi_out_push(midi_out, (MidiOutEvent){ frame, MIDI_OUT_EVENT_NOTE, 0x90 | voice, note, MIDI_VELOCITY });
+    midi_out_holding[voice] = true;
+    midi_out_notes[voice] = note;
+}
+
+// audio thread side, once a block before it is rendered. the block goes out
+// to the device one latency after now, the sender places it from that
+void midi_out_anchor(MidiOut *midi_out, uint64 frame) {
+    if (atomic_load_explicit(&midi_out->mode, memory_order_relaxed) == MIDI_OUT_MODE_OFF) {
+        // the sender silences everything on its way out
+        memset(midi_out_holding, 0, sizeof(midi_out_holding));
+        return;
+    }
+    midi_out_push(midi_out, (MidiOutEvent){ .frame = frame, .type = MIDI_OUT_EVENT_ANCHOR, .time = midi_out_now() });
+}
+
+// where a step of one vibe starts and ends in frames from the start of the
+// chord, false for the ones that do not fit in the vibe
+static bool midi_out_get_step_frames(const SynthParams *params, const VibeStep *step, float fract, int rep, uint32 *on, uint32 *off) {
+    float range = params->time_per_chord / params->vibes_per_chord;
+    float step_start = step->start * fract;
+    float step_end = step->end * fract;
+    if (step_start >= range) {
+        return false;
+    }
+    if (step_end > range) {
+        step_end = range;
+    }
+    *on = (uint32)((rep * range + step_start) * SAMPLE_RATE + 0.5f);
+    *off = (uint32)((rep * range + step_end) * SAMPLE_RATE + 0.5f);
+    return true;
+}
+
+// audio thread side, for every piece of a chord the transport plays. the
+// same notes and step rhythm the midi file export writes, one channel per
+// voice, but only the ones that start or end inside the piece
+void midi_out_play(MidiOut *midi_out, const SynthParams *params, uint32 position, uint32 count, uint64 frame) {
+    if (atomic_load_explicit(&midi_out->mode, memory_order_relaxed) == MIDI_OUT_MODE_OFF) {
+        return;
+    }
+
+    VibeStep steps[16];
+    float fract;
+    int step_count = get_vibe_steps(params->vibe, params->time_per_chord, params->vibes_per_chord, steps, &fract);
+
+    int notes[FREQ_COUNT];
+    get_chord_voicing(params->root, params->third, params->fifth, params->vibe, notes);
+
+    uint64 chord_frame = frame - position;
+    uint32 end = position + count;
+    uint32 on, off;
+
+    // a held note the chord does not have sounding here any more goes first.
+    // that is where a jump of the cursor, an edited cell or a tempo change
+    // shows up, nothing else looks back at what was played
+    bool wanted[FREQ_COUNT] = {0};
+    for (int rep = 0; rep < params->vibes_per_chord; rep++) {
+        for (int i = 0; i < step_count; i++) {
+            if (!midi_out_get_step_frames(params, &steps[i], fract, rep, &on, &off) || position < on || position >= off) {
+                continue;
+            }
+            for (int voice = 0; voice < FREQ_COUNT; voice++) {
+                if ((steps[i].bits & (1 << voice)) != 0 && midi_out_notes[voice] == notes[voice]) {
+                    wanted[voice] = true;
+                }
+            }
+        }
+    }
+    for (int voice = 0; voice < FREQ_COUNT; voice++) {
+        if (!wanted[voice]) {
+            midi_out_note_off(midi_out, frame, voice);
+        }
+    }
+
+    for (int rep = 0; rep < params->vibes_per_chord; rep++) {
+        for (int i = 0; i < step_count; i++) {
+            if (!midi_out_get_step_frames(params, &steps[i], fract, rep, &on, &off)) {
+                continue;
+            }
+            for (int voice = 0; voice < FREQ_COUNT; voice++) {
+                if ((steps[i].bits & (1 << voice)) == 0) {
+                    continue;
+                }
+                if (on >= position && on < end) {
+                    midi_out_note_on(midi_out, chord_frame + on, voice, notes[voice]);
+                }
+                if (off >= position && off < end && midi_out_notes[voice] == notes[voice]) {
+                    midi_out_note_off(midi_out, chord_frame + off, voice);
+                }
+            }
+        }
+    }
+}
+
+// audio thread side, lets go of everything once the transport stops
+void midi_out_stop(MidiOut *midi_out, uint64 frame) {
+    if (atomic_load_explicit(&midi_out->mode, memory_order_relaxed) == MIDI_OUT_MODE_OFF) {
+        return;
+    }
+    for (int voice = 0; voice < FREQ_COUNT; voice++) {
+        midi_out_note_off(midi_out, frame, voice);
+    }
+}
+
+#ifdef __linux__
+
+static bool midi_out_open(MidiOut *midi_out) {
+    if (snd_seq_open(&midi_out_seq, "default", SND_SEQ_OPEN_OUTPUT, 0) < 0) {
+        return false;
+    }
+    snd_seq_set_client_name(midi_out_seq, WINDOW_NAME);
+    snd_seq_set_client_pool_output(midi_out_seq, MIDI_OUT_POOL_SIZE);
+
+    midi_out->port = snd_seq_create_simple_port(
+        midi_out_seq,
+        "progression",
+        SND_SEQ_PORT_CAP_READ | SND_SEQ_PORT_CAP_SUBS_READ,
+        SND_SEQ_PORT_TYPE_MIDI_GENERIC | SND_SEQ_PORT_TYPE_APPLICATION
+    );
+    midi_out_queue = snd_seq_alloc_named_queue(midi_out_seq, WINDOW_NAME);
+    if (midi_out->port < 0 || midi_out_queue < 0) {
+        snd_seq_close(midi_out_seq);
+        return false;
+    }
+
+    snd_seq_start_queue(midi_out_seq, midi_out_queue, NULL);
+    snd_seq_drain_output(midi_out_seq);
+    midi_out->client = snd_seq_client_id(midi_out_seq);
+    return true;
+}
+
+static void midi_out_close() {
+    snd_seq_stop_queue(midi_out_seq, midi_out_queue, NULL);
+    snd_seq_drain_output(midi_out_seq);
+    snd_seq_free_queue(midi_out_seq, midi_out_queue);
+    snd_seq_close(midi_out_seq);
+    midi_out_seq = NULL;
+}
+
+static uint64 midi_out_get_queue_time() {
+    snd_seq_queue_status_t *status;
+    snd_seq_queue_status_alloca(&status);
+    if (snd_seq_get_queue_status(midi_out_seq, midi_out_queue, status) < 0) {
+        return 0;
+    }
+    const snd_seq_real_time_t *time = snd_seq_queue_status_get_real_time(status);
+    return (uint64)time->tv_sec * 1000000000 + time->tv_nsec;
+}
+
+// on the way out. takes back the note ons still waiting on the queue, the
+// note offs stay so nothing hangs, then tells every voice channel to let go
+// anyway
+static void midi_out_silence(MidiOut *midi_out) {
+    snd_seq_drop_output(midi_out_seq);
+
+    snd_seq_remove_events_t *remove;
+    snd_seq_remove_events_alloca(&remove);
+    snd_seq_remove_events_set_queue(remove, midi_out_queue);
+    snd_seq_remove_events_set_condition(remove, SND_SEQ_REMOVE_OUTPUT | SND_SEQ_REMOVE_IGNORE_OFF);
+    snd_seq_remove_events(midi_out_seq, remove);
+
+    for (int voice = 0; voice < FREQ_COUNT; voice++) {
+        snd_seq_event_t ev;
+        snd_seq_ev_clear(&ev);
+        snd_seq_ev_set_source(&ev, midi_out->port);
+        snd_seq_ev_set_subs(&ev);
+        snd_seq_ev_set_direct(&ev);
+        snd_seq_ev_set_controller(&ev, voice, MIDI_OUT_CONTROLLER_ALL_NOTES_OFF, 0);
+        snd_seq_event_output(midi_out_seq, &ev);
+    }
+    snd_seq_drain_output(midi_out_seq);
+}
+
+static void midi_out_send(MidiOut *midi_out, MidiOutEvent event, uint64 time) {
+    snd_seq_event_t ev;
+    snd_seq_ev_clear(&ev);
+    snd_seq_ev_set_source(&ev, midi_out->port);
+    snd_seq_ev_set_subs(&ev);
+
+    snd_seq_real_time_t real_time = { time / 1000000000, time % 1000000000 };
+    snd_seq_ev_schedule_real(&ev, midi_out_queue, 0, &real_time);
+
+    uint8 channel = event.status & 0x0f;
+    if ((event.status & 0xf0) == 0x90) {
+        snd_seq_ev_set_noteon(&ev, channel, event.note, event.velocity);
+    } else {
+        snd_seq_ev_set_noteoff(&ev, channel, event.note, event.velocity);
+    }
+    snd_seq_event_output(midi_out_seq, &ev);
+}
+
+static void *midi_out_thread(void *arg) {
+    MidiOut *midi_out = (MidiOut *)arg;
+
+    // every block the audio thread renders pins its first frame to queue
+    // time, the notes in it are placed by frame distance from that
+    bool anchored = false;
+    uint64 anchor_frame = 0;
+    int64 anchor_time = 0;
+
+    while (atomic_load_explicit(&midi_out->running, memory_order_acquire)) {
+        MidiOutEvent event;
+        bool sent = false;
+        while (midi_out_pop(midi_out, &event)) {
+            if (event.type == MIDI_OUT_EVENT_ANCHOR) {
+                // the queue runs on the system timer, so it keeps pace with
+                // the monotonic clock the anchor was taken on
+                int64 since = (int64)(midi_out_now() - event.time);
+                anchor_frame = event.frame;
+                anchor_time = (int64)midi_out_get_queue_time() - since + MIDI_OUT_LATENCY_NS;
+                anchored = true;
+                continue;
+            }
+            // only when the mode came on halfway through a block
+            if (!anchored) {
+                continue;
+            }
+            int64 time = anchor_time + (int64)(event.frame - anchor_frame) * 1000000000 / SAMPLE_RATE;
+            midi_out_send(midi_out, event, (time > 0) ? (uint64)time : 0);
+            sent = true;
+        }
+        if (sent) {
+            snd_seq_drain_output(midi_out_seq);
+        }
+
+        struct timespec interval = { 0, MIDI_OUT_POLL_INTERVAL_NS };
+        nanosleep(&interval, NULL);
+    }
+
+    midi_out_silence(midi_out);
+    return NULL;
+}
+
+#else
+
+static bool midi_out_open(MidiOut *midi_out) {
+    return false;
+}
+
+static void midi_out_close() {
+}
+
+static void *midi_out_thread(void *arg) {
+    return NULL;
+}
+
+#endif
+
+static bool midi_out_start(MidiOut *midi_out) {
+    if (!midi_out_open(midi_out)) {
+        printf("midi out: could not open the alsa sequencer\n");
+        return false;
+    }
+
+    atomic_store(&midi_out->read_idx, atomic_load(&midi_out->write_idx));
+    atomic_store(&midi_out->dropped, 0);
+    atomic_store(&midi_out->running, true);
+    if (pthread_create(&midi_out->thread, NULL, midi_out_thread, midi_out) != 0) {
+        atomic_store(&midi_out->running, false);
+        midi_out_close();
+        return false;
+    }
+
+    midi_out->started = true;
+    printf("midi out: playing on port %i:%i\n", midi_out->client, midi_out->port);
+    return true;
+}
+
+void stop_midi_out() {
+    MidiOut *midi_out = &state->midi_out;
+    atomic_store(&midi_out->mode, MIDI_OUT_MODE_OFF);
+    if (!midi_out->started) {
+        return;
+    }
+
+    atomic_store(&midi_out->running, false);
+    pthread_join(midi_out->thread, NULL);
+    midi_out_close();
+    midi_out->started = false;
+
+    uint32 dropped = atomic_load(&midi_out->dropped);
+    if (dropped > 0) {
+        printf("midi out: %u events did not fit in the queue\n", dropped);
+    }
+}
+
+// off, next to the synth, instead of the synth, off again
+void cycle_midi_out_mode() {
+    MidiOut *midi_out = &state->midi_out;
+    uint8 mode = (atomic_load(&midi_out->mode) + 1) % MIDI_OUT_MODE_COUNT;
+
+    if (mode == MIDI_OUT_MODE_OFF) {
+        stop_midi_out();
+        return;
+    }
+    if (!midi_out->started && !midi_out_start(midi_out)) {
+        return;
+    }
+    atomic_store(&midi_out->mode, mode);
+}
@@ -3,8 +3,8 @@ float note_to_freq(uint8 note, int octave) {
     return 440.0f * powf(2.0f, semitone_index / 12.0f);
 }
 
-int truncate_note_accidentals(int note) {
-    if (has_flag(FLAG_FLATS)) {
+int truncate_note_accidentals(int note, bool flats) {
+    if (flats) {
         switch (note) {
             case NOTE_A_FLAT: case NOTE_A:  return NOTE_A;
             case NOTE_B_FLAT: case NOTE_B:  return NOTE_B;
@@ -29,69 +29,64 @@ int truncate_note_accidentals(int note) {
     return 0;
 }
 
-void generate_scale(Scale scale) {
-    for (int i = 0; i < SCALE_DEGREE_COUNT; i++) {
-        state->scale[i] = scale[i];
+void get_scale(uint8 scale_type, uint8 *scale) {
+    switch (scale_type) {
+        case SCALE_TYPE_MAJOR: memcpy(scale, SCALE_MAJOR, SCALE_DEGREE_COUNT); break;
+        case SCALE_TYPE_DORIAN: memcpy(scale, SCALE_DORIAN, SCALE_DEGREE_COUNT); break;
+        case SCALE_TYPE_PHRYGIAN: memcpy(scale, SCALE_PHRYGIAN, SCALE_DEGREE_COUNT); break;
+        case SCALE_TYPE_LYDIAN: memcpy(scale, SCALE_LYDIAN, SCALE_DEGREE_COUNT); break;
+        case SCALE_TYPE_MIXOLYDIAN: memcpy(scale, SCALE_MIXOLYDIAN, SCALE_DEGREE_COUNT); break;
+        case SCALE_TYPE_MINOR: memcpy(scale, SCALE_MINOR, SCALE_DEGREE_COUNT); break;
+        case SCALE_TYPE_LOCRIAN: memcpy(scale, SCALE_LOCRIAN, SCALE_DEGREE_COUNT); break;
+        case SCALE_TYPE_HARMONIC_MINOR: memcpy(scale, SCALE_HARMONIC_MINOR, SCALE_DEGREE_COUNT); break;
+        case SCALE_TYPE_MELODIC_MINOR: memcpy(scale, SCALE_MELODIC_MINOR, SCALE_DEGREE_COUNT); break;
     }
 }
 
-void refresh_scale() {
-    switch (state->scale_type) {
-        case SCALE_TYPE_MAJOR: generate_scale(SCALE_MAJOR); break;
-        case SCALE_TYPE_DORIAN: generate_scale(SCALE_DORIAN); break;
-        case SCALE_TYPE_PHRYGIAN: generate_scale(SCALE_PHRYGIAN); break;
-        case SCALE_TYPE_LYDIAN: generate_scale(SCALE_LYDIAN); break;
-        case SCALE_TYPE_MIXOLYDIAN: generate_scale(SCALE_MIXOLYDIAN); break;
-        case SCALE_TYPE_MINOR: generate_scale(SCALE_MINOR); break;
-        case SCALE_TYPE_LOCRIAN: generate_scale(SCALE_LOCRIAN); break;
-        case SCALE_TYPE_HARMONIC_MINOR: generate_scale(SCALE_HARMONIC_MINOR); break;
-        case SCALE_TYPE_MELODIC_MINOR: generate_scale(SCALE_MELODIC_MINOR); break;
-    }
+void refresh_scale(Engine *engine) {
+    get_scale(engine->scale_type, engine->scale);
 }
 
-inline static float get_time_per_chord_range() {
-    return state->max_time_per_chord - state->min_time_per_chord;
+float get_time_per_chord_range(const Engine *engine) {
+    return engine->max_time_per_chord - engine->min_time_per_chord;
 }
 
-#define MIN_TIME_PER_CHORD_DEFAULT 0.5f
-#define MAX_TIME_PER_CHORD_DEFAULT 2.0f
-
-inline static void refresh_time_per_chord_range() {
-    switch (state->vibe) {
+void refresh_time_per_chord_range(Engine *engine) {
+    switch (engine->vibe) {
         default:
-            state->min_time_per_chord = MIN_TIME_PER_CHORD_DEFAULT;
-            state->max_time_per_chord = MAX_TIME_PER_CHORD_DEFAULT;
+            engine->min_time_per_chord = MIN_TIME_PER_CHORD_DEFAULT;
+            engine->max_time_per_chord = MAX_TIME_PER_CHORD_DEFAULT;
             break;
         case VIBE_WALTZ:
-            state->min_time_per_chord = (MIN_TIME_PER_CHORD_DEFAULT * 2);
-            state->max_time_per_chord = (MAX_TIME_PER_CHORD_DEFAULT * 2);
+            engine->min_time_per_chord = (MIN_TIME_PER_CHORD_DEFAULT * 2);
+            engine->max_time_per_chord = (MAX_TIME_PER_CHORD_DEFAULT * 2);
             break;
     }
-    state->min_time_per_chord *= state->vibes_per_chord;
-    state->max_time_per_chord *= state->vibes_per_chord;
+    engine->min_time_per_chord *= engine->vibes_per_chord;
+    engine->max_time_per_chord *= engine->vibes_per_chord;
 }
 
-inline static float get_centralized_time_per_chord() {
-    return state->min_time_per_chord + (get_time_per_chord_range() / 2.0f);
+float get_centralized_time_per_chord(const Engine *engine) {
+    return engine->min_time_per_chord + (get_time_per_chord_range(engine) / 2.0f);
 }
 
-inline static void set_time_per_chord(float value) {
-    state->time_per_chord = value;
-    if (state->time_per_chord < state->min_time_per_chord) {
-        state->time_per_chord = state->min_time_per_chord;
-    } else if (state->time_per_chord > state->max_time_per_chord) {
-        state->time_per_chord = state->max_time_per_chord;
+void set_time_per_chord(Engine *engine, float value) {
+    engine->time_per_chord = value;
+    if (engine->time_per_chord < engine->min_time_per_chord) {
+        engine->time_per_chord = engine->min_time_per_chord;
+    } else if (engine->time_per_chord > engine->max_time_per_chord) {
+        engine->time_per_chord = engine->max_time_per_chord;
     }
 }
 
-bool is_sequencer_active() {
+bool is_sequencer_active(const Engine *engine) {
     for (int i = 0; i < SEQUENCER_AMOUNT; i++) {
-        if (!state->sequencer_states[i]) {
+        if (!engine->sequencer_states[i]) {
             continue;
         }
 
         for (int j = 0; j < SEQUENCER_ROW; j++) {
-            if (state->sequencer[(i * SEQUENCER_ROW) + j] != SCALE_DEGREE_NONE) {
+            if (engine->sequencer[(i * SEQUENCER_ROW) + j] != SCALE_DEGREE_NONE) {
                 return true;
             }
         }
@@ -99,7 +94,8 @@ bool is_sequencer_active() {
     return false;
 }
 
-Chord get_sequencer_chord(int degree) {
+// just the notes and the quality, this runs on the audio and render threads
+Chord make_chord(const uint8 *scale, uint8 scale_root, int degree) {
     Chord chord = {0};
 
     if (degree == SCALE_DEGREE_NONE) {
@@ -107,9 +103,9 @@ Chord get_sequencer_chord(int degree) {
         return chord;
     }
 
-    chord.root = (state->scale[degree % SCALE_DEGREE_COUNT] + state->scale_root) % NOTE_COUNT;
-    chord.third = (state->scale[(degree + 2) % SCALE_DEGREE_COUNT] + state->scale_root) % NOTE_COUNT;
-    chord.fifth = (state->scale[(degree + 4) % SCALE_DEGREE_COUNT] + state->scale_root) % NOTE_COUNT;
+    chord.root = (scale[degree % SCALE_DEGREE_COUNT] + scale_root) % NOTE_COUNT;
+    chord.third = (scale[(degree + 2) % SCALE_DEGREE_COUNT] + scale_root) % NOTE_COUNT;
+    chord.fifth = (scale[(degree + 4) % SCALE_DEGREE_COUNT] + scale_root) % NOTE_COUNT;
 
     int non_inversed_third = chord.third < chord.root ? chord.third + NOTE_COUNT : chord.third;
     int non_inversed_fifth = chord.fifth < chord.root ? chord.fifth + NOTE_COUNT : chord.fifth;
@@ -117,51 +113,55 @@ Chord get_sequencer_chord(int degree) {
     int third_interval = non_inversed_third - chord.root;
     int fifth_interval = non_inversed_fifth - chord.root;
 
-    switch (degree) {
-        case SCALE_DEGREE_I: TextCopy(chord.roman, "I"); break;
-        case SCALE_DEGREE_II: TextCopy(chord.roman, "II"); break;
-        case SCALE_DEGREE_III: TextCopy(chord.roman, "III"); break;
-        case SCALE_DEGREE_IV: TextCopy(chord.roman, "IV"); break;
-        case SCALE_DEGREE_V: TextCopy(chord.roman, "V"); break;
-        case SCALE_DEGREE_VI: TextCopy(chord.roman, "VI"); break;
-        case SCALE_DEGREE_VII: TextCopy(chord.roman, "VII"); break;
-    }
-
     switch (third_interval) {
         case INTERVAL_MAJOR_THIRD:
             switch (fifth_interval) {
-                case INTERVAL_FIFTH:
-                    chord.type = CHORD_TYPE_MAJOR;
-                    break;
-                case INTERVAL_AUGMENTED_FIFTH:
-                    chord.type = CHORD_TYPE_AUGMENTED;
-                    TextCopy(chord.roman, TextFormat("%s+", chord.roman));
-                    break;
-                default:
-                    ASSERT(false);
+                case INTERVAL_FIFTH: chord.type = CHORD_TYPE_MAJOR; break;
+                case INTERVAL_AUGMENTED_FIFTH: chord.type = CHORD_TYPE_AUGMENTED; break;
+                default: ASSERT(false);
             }
             break;
-            break;
         case INTERVAL_MINOR_THIRD:
             switch (fifth_interval) {
-                case INTERVAL_FIFTH:
-                    chord.type = CHORD_TYPE_MINOR;
-                    TextCopy(chord.roman, TextToLower(chord.roman));
-                    break;
-                case INTERVAL_FLAT_FIFTH:
-                    chord.type = CHORD_TYPE_DIMINISHED;
-                    TextCopy(chord.roman, TextToLower(chord.roman));
-                    TextCopy(chord.roman, TextFormat("%s°", chord.roman));
-                    break;
-                default:
-                    ASSERT(false);
+                case INTERVAL_FIFTH: chord.type = CHORD_TYPE_MINOR; break;
+                case INTERVAL_FLAT_FIFTH: chord.type = CHORD_TYPE_DIMINISHED; break;
+                default: ASSERT(false);
             }
             break;
         default:
             ASSERT(false);
     }
 
-    int natural_scale_root = truncate_note_accidentals(state->scale_root);
+    return chord;
+}
+
+static const char *roman_numerals[SCALE_DEGREE_COUNT] = { "I", "II", "III", "IV", "V", "VI", "VII" };
+static const char *roman_numerals_lower[SCALE_DEGREE_COUNT] = { "i", "ii", "iii", "iv", "v", "vi", "vii" };
+
+// the chord with its names filled in, every chord of a scale gets its own letter
+Chord get_sequencer_chord(const Engine *engine, int degree) {
+    Chord chord = make_chord(engine->scale, engine->scale_root, degree);
+
+    if (chord.type == CHORD_TYPE_NONE) {
+        return chord;
+    }
+
+    switch (chord.type) {
+        case CHORD_TYPE_MAJOR:
+            snprintf(chord.roman, CHORD_NAME_CAPACITY, "%s", roman_numerals[degree]);
+            break;
+        case CHORD_TYPE_AUGMENTED:
+            snprintf(chord.roman, CHORD_NAME_CAPACITY, "%s+", roman_numerals[degree]);
+            break;
+        case CHORD_TYPE_MINOR:
+            snprintf(chord.roman, CHORD_NAME_CAPACITY, "%s", roman_numerals_lower[degree]);
+            break;
+        case CHORD_TYPE_DIMINISHED:
+            snprintf(chord.roman, CHORD_NAME_CAPACITY, "%s°", roman_numerals_lower[degree]);
+            break;
+    }
+
+    int natural_scale_root = truncate_note_accidentals(engine->scale_root, engine->flats);
 
     int natural_chord_root = natural_scale_root;
     for (int i = 0; i < degree; i++) {
@@ -169,19 +169,20 @@ Chord get_sequencer_chord(int degree) {
         int new = natural_chord_root;
         while (new == old) {
             natural_chord_root = (natural_chord_root + 1) % NOTE_COUNT;
-            new = truncate_note_accidentals(natural_chord_root);
+            new = truncate_note_accidentals(natural_chord_root, engine->flats);
         }
         natural_chord_root = new;
     }
 
+    char *letter = "";
     switch (natural_chord_root) {
-        case NOTE_A: TextCopy(chord.symbol, "A"); break;
-        case NOTE_B: TextCopy(chord.symbol, "B"); break;
-        case NOTE_C: TextCopy(chord.symbol, "C"); break;
-        case NOTE_D: TextCopy(chord.symbol, "D"); break;
-        case NOTE_E: TextCopy(chord.symbol, "E"); break;
-        case NOTE_F: TextCopy(chord.symbol, "F"); break;
-        case NOTE_G: TextCopy(chord.symbol, "G"); break;
+        case NOTE_A: letter = "A"; break;
+        case NOTE_B: letter = "B"; break;
+        case NOTE_C: letter = "C"; break;
+        case NOTE_D: letter = "D"; break;
+        case NOTE_E: letter = "E"; break;
+        case NOTE_F: letter = "F"; break;
+        case NOTE_G: letter = "G"; break;
         default: ASSERT(false);
     }
 
@@ -189,285 +190,273 @@ Chord get_sequencer_chord(int degree) {
     if (accidentals > NOTE_COUNT / 2) {
         accidentals -= NOTE_COUNT;
     }
-    if (accidentals != 0) {
-        char * accidental_text;
-        switch (accidentals) {
-            case -2: accidental_text = "♭♭"; break;
-            case -1: accidental_text = "♭"; break;
-            case 1: accidental_text = "♯"; break;
-            case 2: accidental_text = "♯♯"; break;
-            default:
-                ASSERT(false);
-        }
-
-        TextCopy(chord.symbol, TextFormat("%s%s", chord.symbol, accidental_text));
+    char *accidental_text = "";
+    switch (accidentals) {
+        case -2: accidental_text = "♭♭"; break;
+        case -1: accidental_text = "♭"; break;
+        case 0: break;
+        case 1: accidental_text = "♯"; break;
+        case 2: accidental_text = "♯♯"; break;
+        default: ASSERT(false);
     }
 
-    if (chord.type != CHORD_TYPE_MAJOR) {
-        char *extension;
-        switch (chord.type) {
-            case CHORD_TYPE_MINOR: extension = "m"; break;
-            case CHORD_TYPE_DIMINISHED: extension = "°"; break;
-            case CHORD_TYPE_AUGMENTED: extension = "+"; break;
-            default: ASSERT(false);
-        }
-
-        TextCopy(chord.symbol, TextFormat("%s%s", chord.symbol, extension));
+    char *extension = "";
+    switch (chord.type) {
+        case CHORD_TYPE_MAJOR: break;
+        case CHORD_TYPE_MINOR: extension = "m"; break;
+        case CHORD_TYPE_DIMINISHED: extension = "°"; break;
+        case CHORD_TYPE_AUGMENTED: extension = "+"; break;
+        default: ASSERT(false);
     }
 
+    snprintf(chord.symbol, CHORD_NAME_CAPACITY, "%s%s%s", letter, accidental_text, extension);
     return chord;
 }
 
-void sequencer_reset_section(int idx) {
-    ASSERT(idx < SEQUENCER_ROWS);
+void sequencer_reset_section(Engine *engine, int idx) {
+    ASSERT(idx < SEQUENCER_AMOUNT);
     int start = idx * SEQUENCER_ROW;
     int end = start + SEQUENCER_ROW;
     for (int i = start; i < end; i++) {
-        state->sequencer[i] = SCALE_DEGREE_NONE;
+        engine->sequencer[i] = SCALE_DEGREE_NONE;
     }
 }
 
-void progress() {
-    state->chord_timer = 0.0f;
+void progress(Engine *engine) {
+    engine->chord_timer = 0.0f;
     Chord chord;
-    if (is_sequencer_active()) {
+    if (is_sequencer_active(engine)) {
         int sequencer_idx;
         do {
-            state->chord_idx = (state->chord_idx + 1) % SEQUENCER_ELEMENTS;
-            sequencer_idx = state->chord_idx / SEQUENCER_ROW;
-            chord = get_sequencer_chord(state->sequencer[state->chord_idx]);
-        } while (!state->sequencer_states[sequencer_idx] || chord.type == CHORD_TYPE_NONE);
+            engine->chord_idx = (engine->chord_idx + 1) % SEQUENCER_ELEMENTS;
+            sequencer_idx = engine->chord_idx / SEQUENCER_ROW;
+            chord = make_chord(engine->scale, engine->scale_root, engine->sequencer[engine->chord_idx]);
+        } while (!engine->sequencer_states[sequencer_idx] || chord.type == CHORD_TYPE_NONE);
     } else {
         chord.type = CHORD_TYPE_NONE;
     }
 }
 
-inline static float trapezoid_ramp(float a, float b, float x) {
-    if (x <= a || x >= b) return 0.0f;
-
-    float len = b - a;
-    float t = (x - a) / len;
-    float ramp = 0.1f;
+#define ENVELOPE_NOTE   ((Envelope){ 0.010f, 0.080f, 0.80f, 0.030f, ENVELOPE_CURVE_LINEAR })
+#define ENVELOPE_PLUCK  ((Envelope){ 0.003f, 0.200f, 0.00f, 0.020f, ENVELOPE_CURVE_EXPONENTIAL })
+#define ENVELOPE_PAD    ((Envelope){ 0.080f, 0.300f, 0.85f, 0.150f, ENVELOPE_CURVE_EXPONENTIAL })
+
+// an exponential segment is snapped to its target once this much of the distance is left
+#define ENVELOPE_EXPONENTIAL_RESIDUE 0.001f
+
+enum {
+    ENVELOPE_SEGMENT_IDLE,
+    ENVELOPE_SEGMENT_ATTACK,
+    ENVELOPE_SEGMENT_DECAY,
+    ENVELOPE_SEGMENT_SUSTAIN,
+    ENVELOPE_SEGMENT_RELEASE,
+};
+
+static void envelope_advance(EnvelopeVoice *voice);
+
+// every segment is level = level * mul + add, so the shape (linear or
+// exponential) and its length only cost something when a segment starts
+static void envelope_enter_segment(EnvelopeVoice *voice, uint8 segment, float target, uint32 samples) {
+    voice->segment = segment;
+    voice->target = target;
+    voice->samples_left = samples;
+
+    if (segment == ENVELOPE_SEGMENT_IDLE || samples == 0) {
+        voice->mul = 1.0f;
+        voice->add = 0.0f;
+        voice->level = target;
+        if (segment != ENVELOPE_SEGMENT_IDLE) {
+            envelope_advance(voice);
+        }
+        return;
+    }
 
-    if (t < ramp) {
-        return t / ramp;
-    } else if (t > 1.0f - ramp) {
-        return (1.0f - t) / ramp;
+    if (voice->curve == ENVELOPE_CURVE_EXPONENTIAL) {
+        float k = expf(logf(ENVELOPE_EXPONENTIAL_RESIDUE) / samples);
+        voice->mul = k;
+        voice->add = target * (1.0f - k);
     } else {
-        return 1.0f;
+        voice->mul = 1.0f;
+        voice->add = (target - voice->level) / samples;
     }
 }
 
-typedef enum ChordBits {
-    BIT_NONE = 0,
-    BIT_1 = 1 << 0,
-    BIT_3 = 1 << 1,
-    BIT_5 = 1 << 2,
-    BIT_5_LOW = 1 << 3,
-    BIT_ALL = ~0,
-} ChordBits;
-
-typedef struct VibeStep {
-    float start;
-    float end;
-    ChordBits bits;
-} VibeStep;
-
-#define FREQ_COUNT 4
-void chord_synthesizer(void *buffer, unsigned int frames) {
-    if (!has_flag(FLAG_PLAYING) || !is_sequencer_active()) {
-        state->chord_timer = 0.0f;
-        return;
+static void envelope_advance(EnvelopeVoice *voice) {
+    voice->level = voice->target;
+    switch (voice->segment) {
+        case ENVELOPE_SEGMENT_ATTACK:
+            envelope_enter_segment(voice, ENVELOPE_SEGMENT_DECAY, voice->sustain, voice->decay_samples);
+            break;
+        case ENVELOPE_SEGMENT_DECAY:
+            envelope_enter_segment(voice, ENVELOPE_SEGMENT_SUSTAIN, voice->sustain, voice->sustain_samples);
+            break;
+        case ENVELOPE_SEGMENT_SUSTAIN:
+            envelope_enter_segment(voice, ENVELOPE_SEGMENT_RELEASE, 0.0f, voice->release_samples);
+            break;
+        case ENVELOPE_SEGMENT_RELEASE:
+            envelope_enter_segment(voice, ENVELOPE_SEGMENT_IDLE, 0.0f, 0);
+            break;
     }
+}
 
-    float sample_rate = 44100.0f;
-
-    Chord chord = get_sequencer_chord(state->sequencer[state->chord_idx]);
+// the gate is cut short by the release time so the note has faded out
+// by the time its step ends, attack and decay give way to a short gate
+static void envelope_note_on(EnvelopeVoice *voice, Envelope envelope, float gain, float gate_time, float sample_rate) {
+    uint32 gate = (gate_time > 0.0f) ? (uint32)(gate_time * sample_rate) : 0;
+    uint32 release = envelope.release * sample_rate;
+    gate = (gate > release) ? gate - release : 0;
 
-    if (chord.type == CHORD_TYPE_NONE) {
-        return;
+    uint32 attack = envelope.attack * sample_rate;
+    if (attack > gate) {
+        attack = gate;
     }
-
-    float freq[FREQ_COUNT];
-
-    {
-        int r = chord.root;
-        int t = chord.third;
-        int f = chord.fifth;
-
-        switch (state->vibe) {
-            case VIBE_POLKA:
-            case VIBE_SWING:
-            case VIBE_WALTZ:
-            case VIBE_CHORD: {
-                if (r < f) {
-                    freq[0] = note_to_freq(r, 4);
-                    freq[1] = note_to_freq(t, 4);
-                    freq[2] = note_to_freq(f, 4);
-                } else if (t < r) {
-                    freq[0] = note_to_freq(t, 4);
-                    freq[1] = note_to_freq(f, 4);
-                    freq[2] = note_to_freq(r, 4);
-                } else {
-                    freq[0] = note_to_freq(f, 4);
-                    freq[1] = note_to_freq(r, 4);
-                    freq[2] = note_to_freq(t, 4);
-                }
-            } break;
-            case VIBE_ROOT:
-            case VIBE_THIRD:
-            case VIBE_FIFTH: {
-                freq[0] = note_to_freq(r, 4);
-                freq[1] = note_to_freq(t, 4);
-                freq[2] = note_to_freq(f, 4);
-            } break;
-        }
-
-        freq[3] = freq[2] / 2.0f;
+    uint32 decay = envelope.decay * sample_rate;
+    if (decay > gate - attack) {
+        decay = gate - attack;
     }
 
-    float lfo_depth = 5.0f;
-    float lfo_rate = 6.0f;
-    static float lfo_phase = 0.0f;
-
-    float cutoff_freq = 500.0f * state->volume_fade;
-    float alpha = 1.0f / (1.0f + (sample_rate / cutoff_freq));
-    static float prev_output = 0.0f;
+    voice->curve = envelope.curve;
+    voice->sustain = envelope.sustain;
+    voice->gain = gain;
+    voice->decay_samples = decay;
+    voice->sustain_samples = gate - attack - decay;
+    voice->release_samples = release;
+    envelope_enter_segment(voice, ENVELOPE_SEGMENT_ATTACK, 1.0f, attack);
+}
 
-    float incr[FREQ_COUNT] = {0};
-    static float phase[FREQ_COUNT] = {0};
-    short *d = (int16 *)buffer;
+static void envelope_note_off(EnvelopeVoice *voice) {
+    if (voice->segment != ENVELOPE_SEGMENT_IDLE && voice->segment != ENVELOPE_SEGMENT_RELEASE) {
+        envelope_enter_segment(voice, ENVELOPE_SEGMENT_RELEASE, 0.0f, voice->release_samples);
+    }
+}
 
-    float range = state->time_per_chord / state->vibes_per_chord;
+inline static float envelope_next(EnvelopeVoice *voice) {
+    voice->level = voice->level * voice->mul + voice->add;
+    if (voice->samples_left > 0 && --voice->samples_left == 0) {
+        envelope_advance(voice);
+    }
+    return voice->level;
+}
 
-    int active_tri = 0;
-    float trapezoid_ramp_multiplier = 0.0f;
 
+// fills steps with the pattern of one vibe, the step times are in units of
+// *fract seconds. returns how many steps there are
+int get_vibe_steps(uint8 vibe, float time_per_chord, uint8 vibes_per_chord, VibeStep *steps, float *fract) {
+    float range = time_per_chord / vibes_per_chord;
     int step_count = 0;
-    VibeStep steps[16];
-    float fract = -1.0f;
 
-    switch (state->vibe) {
+    switch (vibe) {
         case VIBE_POLKA: {
-            fract = range / 8.0f;
-            steps[step_count++] = (VibeStep){ 0.0f, 2.0f, BIT_1 };
-            steps[step_count++] = (VibeStep){ 2.0f, 3.0f, BIT_3|BIT_5 };
-            steps[step_count++] = (VibeStep){ 3.0f, 4.0f, BIT_NONE };
-            steps[step_count++] = (VibeStep){ 4.0f, 6.0f, BIT_5_LOW };
-            steps[step_count++] = (VibeStep){ 6.0f, 7.0f, BIT_3|BIT_5 };
-            steps[step_count++] = (VibeStep){ 7.0f, 8.0f, BIT_NONE };
+            *fract = range / 8.0f;
+            steps[step_count++] = (VibeStep){ 0.0f, 2.0f, BIT_1, ENVELOPE_NOTE };
+            steps[step_count++] = (VibeStep){ 2.0f, 3.0f, BIT_3|BIT_5, ENVELOPE_PLUCK };
+            steps[step_count++] = (VibeStep){ 3.0f, 4.0f, BIT_NONE, ENVELOPE_NOTE };
+            steps[step_count++] = (VibeStep){ 4.0f, 6.0f, BIT_5_LOW, ENVELOPE_NOTE };
+            steps[step_count++] = (VibeStep){ 6.0f, 7.0f, BIT_3|BIT_5, ENVELOPE_PLUCK };
+            steps[step_count++] = (VibeStep){ 7.0f, 8.0f, BIT_NONE, ENVELOPE_NOTE };
             break;
         }
 
         case VIBE_SWING: {
-            fract = range / 6.0f;
-            steps[step_count++] = (VibeStep){ 0.0f, 1.0f, BIT_1 };
-            steps[step_count++] = (VibeStep){ 1.0f, 2.0f, BIT_NONE };
-            steps[step_count++] = (VibeStep){ 2.0f, 3.0f, BIT_3|BIT_5 };
-            steps[step_count++] = (VibeStep){ 3.0f, 4.0f, BIT_5_LOW };
-            steps[step_count++] = (VibeStep){ 4.0f, 5.0f, BIT_NONE };
-            steps[step_count++] = (VibeStep){ 5.0f, 6.0f, BIT_3|BIT_5 };
+            *fract = range / 6.0f;
+            steps[step_count++] = (VibeStep){ 0.0f, 1.0f, BIT_1, ENVELOPE_NOTE };
+            steps[step_count++] = (VibeStep){ 1.0f, 2.0f, BIT_NONE, ENVELOPE_NOTE };
+            steps[step_count++] = (VibeStep){ 2.0f, 3.0f, BIT_3|BIT_5, ENVELOPE_PLUCK };
+            steps[step_count++] = (VibeStep){ 3.0f, 4.0f, BIT_5_LOW, ENVELOPE_NOTE };
+            steps[step_count++] = (VibeStep){ 4.0f, 5.0f, BIT_NONE, ENVELOPE_NOTE };
+            steps[step_count++] = (VibeStep){ 5.0f, 6.0f, BIT_3|BIT_5, ENVELOPE_PLUCK };
             break;
         }
 
         case VIBE_WALTZ: {
-            fract = range / 12.0f;
-            steps[step_count++] = (VibeStep){ 0.0f, 2.0f, BIT_1 };
-            steps[step_count++] = (VibeStep){ 2.0f, 3.0f, BIT_3|BIT_5 };
-            steps[step_count++] = (VibeStep){ 3.0f, 4.0f, BIT_NONE };
-            steps[step_count++] = (VibeStep){ 4.0f, 5.0f, BIT_3|BIT_5 };
-            steps[step_count++] = (VibeStep){ 5.0f, 6.0f, BIT_NONE };
-            steps[step_count++] = (VibeStep){ 6.0f, 8.0f, BIT_5_LOW };
-            steps[step_count++] = (VibeStep){ 8.0f, 9.0f, BIT_3|BIT_5 };
-            steps[step_count++] = (VibeStep){ 9.0f, 10.0f, BIT_NONE };
-            steps[step_count++] = (VibeStep){ 10.0f, 11.0f, BIT_3|BIT_5 };
-            steps[step_count++] = (VibeStep){ 11.0f, 12.0f, BIT_NONE };
+            *fract = range / 12.0f;
+            steps[step_count++] = (VibeStep){ 0.0f, 2.0f, BIT_1, ENVELOPE_NOTE };
+            steps[step_count++] = (VibeStep){ 2.0f, 3.0f, BIT_3|BIT_5, ENVELOPE_PLUCK };
+            steps[step_count++] = (VibeStep){ 3.0f, 4.0f, BIT_NONE, ENVELOPE_NOTE };
+            steps[step_count++] = (VibeStep){ 4.0f, 5.0f, BIT_3|BIT_5, ENVELOPE_PLUCK };
+            steps[step_count++] = (VibeStep){ 5.0f, 6.0f, BIT_NONE, ENVELOPE_NOTE };
+            steps[step_count++] = (VibeStep){ 6.0f, 8.0f, BIT_5_LOW, ENVELOPE_NOTE };
+            steps[step_count++] = (VibeStep){ 8.0f, 9.0f, BIT_3|BIT_5, ENVELOPE_PLUCK };
+            steps[step_count++] = (VibeStep){ 9.0f, 10.0f, BIT_NONE, ENVELOPE_NOTE };
+            steps[step_count++] = (VibeStep){ 10.0f, 11.0f, BIT_3|BIT_5, ENVELOPE_PLUCK };
+            steps[step_count++] = (VibeStep){ 11.0f, 12.0f, BIT_NONE, ENVELOPE_NOTE };
             break;
         }
 
         case VIBE_CHORD: {
-            fract = state->time_per_chord;
-            steps[step_count++] = (VibeStep){ 0.0f, 1.0f, BIT_ALL };
+            *fract = time_per_chord;
+            steps[step_count++] = (VibeStep){ 0.0f, 1.0f, BIT_ALL, ENVELOPE_PAD };
             break;
         }
 
         case VIBE_ROOT: {
-            fract = state->time_per_chord;
-            steps[step_count++] = (VibeStep){ 0.0f, 1.0f, BIT_1 };
+            *fract = time_per_chord;
+            steps[step_count++] = (VibeStep){ 0.0f, 1.0f, BIT_1, ENVELOPE_PAD };
             break;
         }
 
         case VIBE_THIRD: {
-            fract = state->time_per_chord;
-            steps[step_count++] = (VibeStep){ 0.0f, 1.0f, BIT_3 };
+            *fract = time_per_chord;
+            steps[step_count++] = (VibeStep){ 0.0f, 1.0f, BIT_3, ENVELOPE_PAD };
             break;
         }
 
         case VIBE_FIFTH: {
-            fract = state->time_per_chord;
-            steps[step_count++] = (VibeStep){ 0.0f, 1.0f, BIT_5 };
+            *fract = time_per_chord;
+            steps[step_count++] = (VibeStep){ 0.0f, 1.0f, BIT_5, ENVELOPE_PAD };
             break;
         }
     }
 
-    ASSERT(step_count > 0);
-    ASSERT(fract >= 0.0f);
-
-    for (uint32 i = 0; i < frames; i++) {
-        float local_time = fmodf(state->chord_timer, range);
-
-        for (size_t i = 0; i < step_count; i++) {
-            VibeStep *s = &steps[i];
-            float start = s->start * fract;
-            float end = s->end * fract;
-            if (local_time >= start && local_time < end) {
-                active_tri = s->bits;
-                trapezoid_ramp_multiplier = trapezoid_ramp(start, end, local_time);
-                break;
-            }
-        }
-
-        float vibrato = sinf(2 * PI * lfo_phase) * lfo_depth;
+    return step_count;
+}
 
-        float tri[4] = {0};
+// voicing of the chord for a vibe as midi notes, in the order of ChordBits.
+// the strummed vibes keep the notes close
+void get_chord_voicing(uint8 root, uint8 third, uint8 fifth, uint8 vibe, int *notes) {
+    int r = root;
+    int t = third;
+    int f = fifth;
 
-        for (int j = 0; j < FREQ_COUNT; j++) {
-            float vibrated_freq = freq[j] * (1.0f + vibrato / freq[j]);
-            incr[j] = vibrated_freq / sample_rate;
-            tri[j] = (phase[j] < 0.5f) ? (4.0f * phase[j] - 1.0f) : (3.0f - 4.0f * phase[j]);
-        }
-
-        float sample = 0.0f;
-        int divide = 0;
-        for (int j = 0; j < FREQ_COUNT; j++) {
-            if ((active_tri & (1 << j)) != 0) {
-                sample += tri[j];
-                divide++;
+    switch (vibe) {
+        case VIBE_POLKA:
+        case VIBE_SWING:
+        case VIBE_WALTZ:
+        case VIBE_CHORD: {
+            if (r < f) {
+                notes[0] = r;
+                notes[1] = t;
+                notes[2] = f;
+            } else if (t < r) {
+                notes[0] = t;
+                notes[1] = f;
+                notes[2] = r;
+            } else {
+                notes[0] = f;
+                notes[1] = r;
+                notes[2] = t;
             }
-        }
-        if (divide > 0) {
-            sample /= divide;
-        }
-
-        float filtered_sample = alpha * sample + (1.0f - alpha) * prev_output;
-        prev_output = filtered_sample;
-
-        d[i] = (short)(32000.0f * filtered_sample)
-            * state->volume_fade
-            * state->volume_manual
-            * trapezoid_ramp_multiplier;
-
-        for (int j = 0; j < FREQ_COUNT; j++) {
-            phase[j] += incr[j];
-            if (phase[j] > 1.0f) phase[j] -= 1.0f;
-        }
+        } break;
+        case VIBE_ROOT:
+        case VIBE_THIRD:
+        case VIBE_FIFTH: {
+            notes[0] = r;
+            notes[1] = t;
+            notes[2] = f;
+        } break;
+    }
 
-        lfo_phase += lfo_rate / sample_rate;
-        if (lfo_phase > 1.0f) lfo_phase -= 1.0f;
+    for (int i = 0; i < 3; i++) {
+        notes[i] += MIDI_NOTE_A4;
+    }
+    notes[3] = notes[2] - 12;
+}
 
-        state->chord_timer += 1.0 / sample_rate;
-        if (state->chord_timer > state->time_per_chord) {
-            progress();
-        }
+void get_chord_freqs(uint8 root, uint8 third, uint8 fifth, uint8 vibe, float *freq) {
+    int notes[FREQ_COUNT];
+    get_chord_voicing(root, third, fifth, vibe, notes);
+    for (int i = 0; i < 3; i++) {
+        freq[i] = note_to_freq(notes[i] - MIDI_NOTE_A4, 4);
     }
+    freq[3] = freq[2] / 2.0f;
 }
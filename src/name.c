@@ -1,5 +1,5 @@
 const char *get_note_name(int note) {
-    if (has_flag(FLAG_FLATS)) {
+    if (state->engine.flats) {
         switch (note) {
             case NOTE_A: return "A";
             case NOTE_B_FLAT: return "B♭";
@@ -34,6 +34,26 @@ const char *get_note_name(int note) {
     return NULL;
 }
 
+// plain ascii for file names, always sharps
+const char *get_note_file_name(int note) {
+    switch (note) {
+        case NOTE_A: return "A";
+        case NOTE_A_SHARP: return "A#";
+        case NOTE_B: return "B";
+        case NOTE_C: return "C";
+        case NOTE_C_SHARP: return "C#";
+        case NOTE_D: return "D";
+        case NOTE_D_SHARP: return "D#";
+        case NOTE_E: return "E";
+        case NOTE_F: return "F";
+        case NOTE_F_SHARP: return "F#";
+        case NOTE_G: return "G";
+        case NOTE_G_SHARP: return "G#";
+    }
+    ASSERT(false);
+    return NULL;
+}
+
 const char *get_scale_name(int scale_type) {
     switch (scale_type) {
         case SCALE_TYPE_MAJOR: return "Major";
@@ -50,6 +70,22 @@ const char *get_scale_name(int scale_type) {
     return NULL;
 }
 
+const char *get_scale_file_name(int scale_type) {
+    switch (scale_type) {
+        case SCALE_TYPE_MAJOR: return "major";
+        case SCALE_TYPE_DORIAN: return "dorian";
+        case SCALE_TYPE_PHRYGIAN: return "phrygian";
+        case SCALE_TYPE_LYDIAN: return "lydian";
+        case SCALE_TYPE_MIXOLYDIAN: return "mixolydian";
+        case SCALE_TYPE_MINOR: return "minor";
+        case SCALE_TYPE_LOCRIAN: return "locrian";
+        case SCALE_TYPE_HARMONIC_MINOR: return "harmonic_minor";
+        case SCALE_TYPE_MELODIC_MINOR: return "melodic_minor";
+    }
+    ASSERT(false);
+    return NULL;
+}
+
 const char *get_vibe_name(int vibe) {
     switch (vibe) {
         case VIBE_POLKA: return "Polka";
@@ -64,3 +100,28 @@ const char *get_vibe_name(int vibe) {
     return NULL;
 }
 
+
+const char *get_midi_import_result_name(uint8 result) {
+    switch (result) {
+        case MIDI_IMPORT_OK: return "ok";
+        case MIDI_IMPORT_UNREADABLE: return "could not read it";
+        case MIDI_IMPORT_NOT_MIDI: return "not a midi file";
+        case MIDI_IMPORT_NO_CHORDS: return "no triads in it";
+    }
+    ASSERT(false);
+    return NULL;
+}
+
+const char *get_profile_section_name(int section) {
+    switch (section) {
+        case PROFILE_SECTION_UPDATE: return "update";
+        case PROFILE_SECTION_DRAW_SEQUENCER: return "draw_sequencer";
+        case PROFILE_SECTION_DRAW_CONTROLS: return "draw_controls";
+        case PROFILE_SECTION_DRAW_OTHER: return "draw (other)";
+        case PROFILE_SECTION_END_DRAWING: return "swap";
+        case PROFILE_SECTION_TEXT: return "text";
+        case PROFILE_SECTION_FFT: return "fft";
+    }
+    ASSERT(false);
+    return NULL;
+}
@@ -0,0 +1,249 @@
+// a bar of a given chord, vibe and tempo always sounds the same, so with the
+// cache on a worker thread renders every distinct bar of the progression once
+// and the audio callback only copies them. anything not (yet) cached is
+// synthesised live as before
+
+static int pcm_cache_find(PcmCache *cache, const SynthParams *params) {
+    for (int i = 0; i < PCM_CACHE_ENTRY_COUNT; i++) {
+        PcmCacheEntry *entry = &cache->entries[i];
+        if (atomic_load(&entry->status) == PCM_CACHE_ENTRY_READY && synth_params_equal(&entry->params, params)) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static bool pcm_cache_is_wanted(const SynthParams *wanted, int wanted_count, const SynthParams *params) {
+    for (int i = 0; i < wanted_count; i++) {
+        if (synth_params_equal(&wanted[i], params)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// the status is swapped before the pins are looked at and the callback pins
+// before it looks at the status, so one of the two always sees the other
+static bool pcm_cache_evict(PcmCache *cache, PcmCacheEntry *entry) {
+    int expected = PCM_CACHE_ENTRY_READY;
+    if (!atomic_compare_exchange_strong(&entry->status, &expected, PCM_CACHE_ENTRY_EVICTING)) {
+        return false;
+    }
+    if (atomic_load(&entry->pins) != 0) {
+        atomic_store(&entry->status, PCM_CACHE_ENTRY_READY);
+        return false;
+    }
+
+    atomic_fetch_sub(&cache->bytes, entry->frame_count * sizeof(int16));
+    atomic_fetch_sub(&cache->ready_count, 1);
+    free(entry->samples);
+    entry->samples = NULL;
+    entry->frame_count = 0;
+    atomic_store(&entry->status, PCM_CACHE_ENTRY_EMPTY);
+    return true;
+}
+
+// least recently played entry that is not part of the progression anymore
+static PcmCacheEntry *pcm_cache_get_eviction_candidate(PcmCache *cache, const SynthParams *wanted, int wanted_count) {
+    PcmCacheEntry *candidate = NULL;
+    uint64 oldest = UINT64_MAX;
+    for (int i = 0; i < PCM_CACHE_ENTRY_COUNT; i++) {
+        PcmCacheEntry *entry = &cache->entries[i];
+        if (atomic_load(&entry->status) != PCM_CACHE_ENTRY_READY || pcm_cache_is_wanted(wanted, wanted_count, &entry->params)) {
+            continue;
+        }
+        uint64 last_used = atomic_load(&entry->last_used);
+        if (last_used < oldest) {
+            oldest = last_used;
+            candidate = entry;
+        }
+    }
+    return candidate;
+}
+
+static PcmCacheEntry *pcm_cache_get_empty_entry(PcmCache *cache) {
+    for (int i = 0; i < PCM_CACHE_ENTRY_COUNT; i++) {
+        if (atomic_load(&cache->entries[i].status) == PCM_CACHE_ENTRY_EMPTY) {
+            return &cache->entries[i];
+        }
+    }
+    return NULL;
+}
+
+static void pcm_cache_render(PcmCache *cache, Synth *synth, const SynthParams *params, const SynthParams *wanted, int wanted_count) {
+    uint32 frame_count = get_chord_frame_count(params->time_per_chord);
+    uint32 size = frame_count * sizeof(int16);
+    if (size > PCM_CACHE_BUDGET) {
+        return;
+    }
+
+    PcmCacheEntry *entry = pcm_cache_get_empty_entry(cache);
+    while (entry == NULL || atomic_load(&cache->bytes) + size > PCM_CACHE_BUDGET) {
+        PcmCacheEntry *candidate = pcm_cache_get_eviction_candidate(cache, wanted, wanted_count);
+        // the rest of the progression does not fit, it stays live
+        if (candidate == NULL || !pcm_cache_evict(cache, candidate)) {
+            return;
+        }
+        if (entry == NULL) {
+            entry = candidate;
+        }
+    }
+
+    int16 *samples = (int16 *)malloc(size);
+    if (samples == NULL) {
+        return;
+    }
+
+    synth_reset(synth);
+    for (uint32 i = 0; i < frame_count; i += SYNTH_RENDER_CHUNK) {
+        uint32 count = (frame_count - i < SYNTH_RENDER_CHUNK) ? frame_count - i : SYNTH_RENDER_CHUNK;
+        synth_render(synth, params, i / (float)SAMPLE_RATE, false, samples + i, count);
+    }
+
+    entry->params = *params;
+    entry->samples = samples;
+    entry->frame_count = frame_count;
+    atomic_store(&entry->last_used, atomic_fetch_add(&cache->clock, 1));
+    atomic_fetch_add(&cache->bytes, size);
+    atomic_fetch_add(&cache->ready_count, 1);
+    atomic_store(&entry->status, PCM_CACHE_ENTRY_READY);
+}
+
+static void *pcm_cache_worker(void *arg) {
+    PcmCache *cache = (PcmCache *)arg;
+    Synth *synth = (Synth *)malloc(sizeof(Synth));
+    SynthParams wanted[SEQUENCER_ELEMENTS];
+    int wanted_count;
+
+    flush_denormals();
+
+    pthread_mutex_lock(&cache->mutex);
+    while (!cache->quit) {
+        if (!cache->dirty) {
+            pthread_cond_wait(&cache->wake, &cache->mutex);
+            continue;
+        }
+
+        wanted_count = cache->wanted_count;
+        memcpy(wanted, cache->wanted, wanted_count * sizeof(SynthParams));
+        cache->dirty = false;
+        pthread_mutex_unlock(&cache->mutex);
+
+        for (int i = 0; i < wanted_count && synth != NULL; i++) {
+            if (pcm_cache_find(cache, &wanted[i]) < 0) {
+                pcm_cache_render(cache, synth, &wanted[i], wanted, wanted_count);
+            }
+        }
+
+        pthread_mutex_lock(&cache->mutex);
+    }
+    pthread_mutex_unlock(&cache->mutex);
+
+    free(synth);
+    return NULL;
+}
+
+void pcm_cache_init(PcmCache *cache) {
+    pthread_mutex_init(&cache->mutex, NULL);
+    pthread_cond_init(&cache->wake, NULL);
+    pthread_create(&cache->thread, NULL, pcm_cache_worker, cache);
+}
+
+// the audio stream has to be stopped before this, nothing may be pinned
+void pcm_cache_destroy(PcmCache *cache) {
+    pthread_mutex_lock(&cache->mutex);
+    cache->quit = true;
+    pthread_cond_signal(&cache->wake);
+    pthread_mutex_unlock(&cache->mutex);
+    pthread_join(cache->thread, NULL);
+
+    for (int i = 0; i < PCM_CACHE_ENTRY_COUNT; i++) {
+        free(cache->entries[i].samples);
+    }
+    pthread_cond_destroy(&cache->wake);
+    pthread_mutex_destroy(&cache->mutex);
+}
+
+// copies count frames of the bar starting at offset, false on a miss
+bool pcm_cache_read(PcmCache *cache, const SynthParams *params, uint32 offset, int16 *out, uint32 count) {
+    for (int i = 0; i < PCM_CACHE_ENTRY_COUNT; i++) {
+        PcmCacheEntry *entry = &cache->entries[i];
+        if (atomic_load(&entry->status) != PCM_CACHE_ENTRY_READY) {
+            continue;
+        }
+
+        atomic_fetch_add(&entry->pins, 1);
+        bool hit = (
+            atomic_load(&entry->status) == PCM_CACHE_ENTRY_READY &&
+            synth_params_equal(&entry->params, params) &&
+            offset + count <= entry->frame_count
+        );
+        if (hit) {
+            memcpy(out, entry->samples + offset, count * sizeof(int16));
+            atomic_store(&entry->last_used, atomic_fetch_add(&cache->clock, 1));
+        }
+        atomic_fetch_sub(&entry->pins, 1);
+
+        if (hit) {
+            return true;
+        }
+    }
+    return false;
+}
+
+SynthParams get_synth_params(const Engine *engine, Chord chord, float time_per_chord, float cutoff) {
+    return (SynthParams){
+        .root = chord.root,
+        .third = chord.third,
+        .fifth = chord.fifth,
+        .vibe = engine->vibe,
+        .vibes_per_chord = engine->vibes_per_chord,
+        .time_per_chord = time_per_chord,
+        .cutoff = cutoff,
+        .resonance = engine->filter_resonance,
+        .key_tracking = engine->filter_key_tracking,
+    };
+}
+
+// called by the ui every frame, only wakes the worker when the set of
+// bars the progression needs has changed
+void pcm_cache_request(Engine *engine) {
+    PcmCache *cache = &engine->pcm_cache;
+    if (!engine->use_pcm_cache || !engine->pcm_cache_started) {
+        return;
+    }
+
+    SynthParams requested[SEQUENCER_ELEMENTS];
+    int requested_count = 0;
+    for (int i = 0; i < SEQUENCER_ELEMENTS; i++) {
+        if (!engine->sequencer_states[i / SEQUENCER_ROW]) {
+            continue;
+        }
+        Chord chord = make_chord(engine->scale, engine->scale_root, engine->sequencer[i]);
+        if (chord.type == CHORD_TYPE_NONE) {
+            continue;
+        }
+        SynthParams params = get_synth_params(engine, chord, engine->time_per_chord, engine->filter_cutoff);
+        if (!pcm_cache_is_wanted(requested, requested_count, &params)) {
+            requested[requested_count++] = params;
+        }
+    }
+
+    bool changed = requested_count != cache->requested_count;
+    for (int i = 0; i < requested_count && !changed; i++) {
+        changed = !synth_params_equal(&requested[i], &cache->requested[i]);
+    }
+    if (!changed) {
+        return;
+    }
+
+    memcpy(cache->requested, requested, requested_count * sizeof(SynthParams));
+    cache->requested_count = requested_count;
+
+    pthread_mutex_lock(&cache->mutex);
+    memcpy(cache->wanted, requested, requested_count * sizeof(SynthParams));
+    cache->wanted_count = requested_count;
+    cache->dirty = true;
+    pthread_cond_signal(&cache->wake);
+    pthread_mutex_unlock(&cache->mutex);
+}
@@ -0,0 +1,117 @@
+inline static ProfileFrame *get_profile_frame(int frames_ago) {
+    Profiler *profiler = &state->profiler;
+    int idx = (profiler->frame_idx - frames_ago + PROFILE_FRAME_COUNT) % PROFILE_FRAME_COUNT;
+    return &profiler->frames[idx];
+}
+
+void profile_begin_frame() {
+    Profiler *profiler = &state->profiler;
+    double now = GetTime();
+
+    if (profiler->frame_count > 0) {
+        profiler->frames[profiler->frame_idx].end = now;
+        profiler->frame_idx = (profiler->frame_idx + 1) % PROFILE_FRAME_COUNT;
+    }
+    if (profiler->frame_count < PROFILE_FRAME_COUNT) {
+        profiler->frame_count++;
+    }
+
+    ProfileFrame *frame = &profiler->frames[profiler->frame_idx];
+    *frame = (ProfileFrame){0};
+    frame->start = now;
+    frame->end = now;
+}
+
+inline static void profile_begin(int section) {
+    state->profiler.open[section] = GetTime();
+}
+
+// sections can be entered several times per frame (text is),
+// the frame keeps the first start and the summed duration
+inline static void profile_end(int section) {
+    Profiler *profiler = &state->profiler;
+    ProfileFrame *frame = &profiler->frames[profiler->frame_idx];
+    double start = profiler->open[section];
+    if (frame->section_time[section] == 0.0) {
+        frame->section_start[section] = start;
+    }
+    frame->section_time[section] += GetTime() - start;
+}
+
+static int compare_doubles(const void *a, const void *b) {
+    double x = *(const double *)a;
+    double y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+// only finished frames are looked at, the one being recorded is skipped
+void get_profile_percentiles(int section, double *p50, double *p99) {
+    int count = state->profiler.frame_count - 1;
+    *p50 = 0.0;
+    *p99 = 0.0;
+    if (count <= 0) {
+        return;
+    }
+
+    double times[PROFILE_FRAME_COUNT];
+    for (int i = 0; i < count; i++) {
+        times[i] = get_profile_frame(i + 1)->section_time[section];
+    }
+    qsort(times, count, sizeof(double), compare_doubles);
+
+    *p50 = times[(count - 1) / 2];
+    *p99 = times[((count - 1) * 99) / 100];
+}
+
+// writes the recorded frames as chrome trace events (chrome://tracing, perfetto),
+// text is put on its own track since it happens inside the draw sections
+bool export_profile_trace(const char *file_name) {
+    FILE *file = fopen(file_name, "w");
+    if (file == NULL) {
+        return false;
+    }
+
+    int count = state->profiler.frame_count - 1;
+    bool first = true;
+
+    fprintf(file, "{\"traceEvents\":[\n");
+    for (int i = count; i > 0; i--) {
+        ProfileFrame *frame = get_profile_frame(i);
+
+        fprintf(
+            file,
+            "%s{\"name\":\"frame\",\"cat\":\"frame\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":0}",
+            first ? "" : ",\n",
+            frame->start * 1e6,
+            (frame->end - frame->start) * 1e6
+        );
+        first = false;
+
+        fprintf(
+            file,
+            ",\n{\"name\":\"gpu\",\"ph\":\"C\",\"ts\":%.3f,\"pid\":1,\"args\":{\"draw_calls\":%u,\"vertices\":%u,\"batch_flushes\":%u}}",
+            frame->start * 1e6,
+            frame->draw_calls,
+            frame->vertices,
+            frame->batch_flushes
+        );
+
+        for (int j = 0; j < PROFILE_SECTION_COUNT; j++) {
+            if (frame->section_time[j] == 0.0) {
+                continue;
+            }
+            fprintf(
+                file,
+                ",\n{\"name\":\"%s\",\"cat\":\"section\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%d}",
+                get_profile_section_name(j),
+                frame->section_start[j] * 1e6,
+                frame->section_time[j] * 1e6,
+                (j == PROFILE_SECTION_TEXT) ? 2 : 1
+            );
+        }
+    }
+    fprintf(file, "\n]}\n");
+
+    fclose(file);
+    return true;
+}
@@ -0,0 +1,154 @@
+#include <time.h>
+
+// records what the app plays. the callback only copies into a ring, a thread
+// takes whole chunks out of it and streams them into a wav or flac file, so
+// memory stays the same however long the session goes on
+
+#define RECORDER_CHUNK 4096
+#define RECORDER_POLL_INTERVAL_NS 20000000
+
+// audio thread side, never blocks, drops what does not fit.
+// samples can be NULL for silence
+void recorder_push(Recorder *recorder, const int16 *samples, uint32 count) {
+    if (!atomic_load_explicit(&recorder->recording, memory_order_acquire)) {
+        return;
+    }
+
+    uint32 write_idx = atomic_load_explicit(&recorder->write_idx, memory_order_relaxed);
+    uint32 read_idx = atomic_load_explicit(&recorder->read_idx, memory_order_acquire);
+    uint32 space = RECORDER_RING_CAPACITY - (write_idx - read_idx);
+    if (count > space) {
+        atomic_fetch_add_explicit(&recorder->dropped, count - space, memory_order_relaxed);
+        LOG(LOG_LEVEL_WARNING, LOG_CODE_RECORDER_DROPPED, count - space);
+        count = space;
+    }
+
+    for (uint32 i = 0; i < count; i++) {
+        recorder->ring[(write_idx + i) & RECORDER_RING_MASK] = (samples != NULL) ? samples[i] : 0;
+    }
+    atomic_store_explicit(&recorder->write_idx, write_idx + count, memory_order_release);
+}
+
+static uint32 recorder_pop(Recorder *recorder, int16 *samples, uint32 capacity) {
+    uint32 read_idx = atomic_load_explicit(&recorder->read_idx, memory_order_relaxed);
+    uint32 write_idx = atomic_load_explicit(&recorder->write_idx, memory_order_acquire);
+    uint32 count = write_idx - read_idx;
+    if (count > capacity) {
+        count = capacity;
+    }
+
+    for (uint32 i = 0; i < count; i++) {
+        samples[i] = recorder->ring[(read_idx + i) & RECORDER_RING_MASK];
+    }
+    atomic_store_explicit(&recorder->read_idx, read_idx + count, memory_order_release);
+    return count;
+}
+
+static void *recorder_thread(void *arg) {
+    Recorder *recorder = (Recorder *)arg;
+    bool flac = recorder->format == RECORDING_FORMAT_FLAC;
+    FlacWriter *flac_writer = NULL;
+    WavWriter *wav_writer = NULL;
+    bool opened;
+
+    if (flac) {
+        flac_writer = (FlacWriter *)malloc(sizeof(FlacWriter));
+        opened = flac_writer != NULL && flac_writer_open(flac_writer, recorder->file_name, SAMPLE_RATE);
+    } else {
+        wav_writer = (WavWriter *)malloc(sizeof(WavWriter));
+        opened = wav_writer != NULL && wav_writer_open(wav_writer, recorder->file_name, SAMPLE_RATE, 1);
+    }
+
+    if (!opened) {
+        printf("recorder: could not open %s\n", recorder->file_name);
+        atomic_store(&recorder->recording, false);
+        free(flac_writer);
+        free(wav_writer);
+        return NULL;
+    }
+
+    int16 chunk[RECORDER_CHUNK];
+    for (;;) {
+        // looked at before popping so nothing pushed before the stop is left behind
+        bool stopping = !atomic_load_explicit(&recorder->recording, memory_order_acquire);
+        uint32 count = recorder_pop(recorder, chunk, RECORDER_CHUNK);
+
+        if (count > 0) {
+            if (flac) {
+                flac_writer_write(flac_writer, chunk, count);
+            } else {
+                wav_writer_write(wav_writer, chunk, count);
+            }
+            atomic_fetch_add_explicit(&recorder->written, count, memory_order_relaxed);
+            continue;
+        }
+        if (stopping) {
+            break;
+        }
+
+        struct timespec interval = { 0, RECORDER_POLL_INTERVAL_NS };
+        nanosleep(&interval, NULL);
+    }
+
+    bool ok = flac ? flac_writer_close(flac_writer) : wav_writer_close(wav_writer);
+    if (!ok) {
+        printf("recorder: could not finish %s\n", recorder->file_name);
+    }
+    free(flac_writer);
+    free(wav_writer);
+    return NULL;
+}
+
+void start_recording(uint8 format) {
+    Recorder *recorder = &state->recorder;
+    if (recorder->started) {
+        return;
+    }
+
+    time_t now = time(NULL);
+    char stamp[32];
+    strftime(stamp, sizeof(stamp), "%Y%m%d_%H%M%S", localtime(&now));
+    snprintf(
+        recorder->file_name,
+        RECORDER_FILE_NAME_CAPACITY,
+        "recording_%s.%s",
+        stamp,
+        (format == RECORDING_FORMAT_FLAC) ? "flac" : "wav"
+    );
+
+    recorder->format = format;
+    atomic_store(&recorder->read_idx, atomic_load(&recorder->write_idx));
+    atomic_store(&recorder->dropped, 0);
+    atomic_store(&recorder->written, 0);
+    atomic_store(&recorder->recording, true);
+
+    if (pthread_create(&recorder->thread, NULL, recorder_thread, recorder) == 0) {
+        recorder->started = true;
+    } else {
+        atomic_store(&recorder->recording, false);
+    }
+}
+
+void stop_recording() {
+    Recorder *recorder = &state->recorder;
+    if (!recorder->started) {
+        return;
+    }
+
+    atomic_store(&recorder->recording, false);
+    pthread_join(recorder->thread, NULL);
+    recorder->started = false;
+
+    uint32 dropped = atomic_load(&recorder->dropped);
+    if (dropped > 0) {
+        printf("recorder: %s is missing %u samples, the disk could not keep up\n", recorder->file_name, dropped);
+    }
+}
+
+void toggle_recording(uint8 format) {
+    if (state->recorder.started) {
+        stop_recording();
+    } else {
+        start_recording(format);
+    }
+}
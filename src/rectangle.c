@@ -1,125 +1,202 @@
-Rectangle get_file_controls_rectangle() {
-    float height = get_thing_height();
-    return (Rectangle) {
-        .x = 0,
-        .y = height * VERTICAL_POSITION_OF_FILE_CONTROLS,
-        .width = GetScreenWidth(),
-        .height = height,
-    };
-}
-
-Rectangle get_load_file_rectangle() {
-    Rectangle rec = get_file_controls_rectangle();
-    rec.width /= 2;
+inline static Rectangle split_rectangle_horizontally(Rectangle rec, int idx, int count) {
+    rec.width /= count;
+    rec.x += rec.width * idx;
     return rec;
 }
 
-Rectangle get_save_file_rectangle() {
-    Rectangle rec = get_file_controls_rectangle();
-    rec.x = rec.x + (rec.width / 2);
-    rec.width /= 2;
+inline static Rectangle split_rectangle_vertically(Rectangle rec, int idx, int count) {
+    rec.height /= count;
+    rec.y += rec.height * idx;
     return rec;
 }
 
-Rectangle get_control_rectangle(int control) {
-    float width = GetScreenWidth() / 2;
-    float height = get_thing_height();
-    int x_idx = control / CONTROLS_COLUMN_COUNT;
-    int y_idx = control % CONTROLS_COLUMN_COUNT;
-    int split_point = CONTROLS_COUNT / 2;
-    return (Rectangle) {
-        .x = width * x_idx,
-        .y = (height * VERTICAL_POSITION_OF_CONTROLS) + (height * y_idx),
+// everything in here only changes when the window does,
+// so it is computed once per resize and the getters below just read it back
+void refresh_layout(int width, int height) {
+    Layout *layout = &state->layout;
+
+    layout->screen_width = width;
+    layout->screen_height = height;
+    layout->size_multiplier = (width < height) ? width : height;
+    layout->font_size = 0.04f * layout->size_multiplier;
+    layout->thing_height = height / VERTICAL_POSITION_COUNT;
+
+    float thing_height = layout->thing_height;
+
+    Rectangle file_controls = {
+        .x = 0,
+        .y = thing_height * VERTICAL_POSITION_OF_FILE_CONTROLS,
+        .width = width,
+        .height = thing_height,
+    };
+    layout->load_file = split_rectangle_horizontally(file_controls, 0, 2);
+    layout->save_file = split_rectangle_horizontally(file_controls, 1, 2);
+
+    layout->play_button = (Rectangle) {
+        .x = 0,
+        .y = thing_height * VERTICAL_POSITION_OF_PLAY_BUTTON,
+        .width = width,
+        .height = thing_height,
+    };
+
+    layout->cmd = (Rectangle) {
+        .x = 0,
+        .y = thing_height * VERTICAL_POSITION_OF_CMD,
         .width = width,
-        .height = height,
+        .height = thing_height,
     };
+
+    float element_width = (float)width / ((float)SEQUENCER_ROW + 1.0f);
+
+    layout->sequencer = (Rectangle) {
+        .x = element_width,
+        .y = thing_height * VERTICAL_POSITION_OF_SEQUENCER,
+        .width = element_width * SEQUENCER_ROW,
+        .height = thing_height * SEQUENCER_ROWS,
+    };
+    layout->sequencer_element_width = element_width;
+    layout->sequencer_element_height = layout->sequencer.height / SEQUENCER_AMOUNT;
+
+    layout->sequencer_state_section = layout->sequencer;
+    layout->sequencer_state_section.width = element_width;
+    layout->sequencer_state_section.x -= element_width;
+
+    for (int i = 0; i < SEQUENCER_AMOUNT; i++) {
+        Rectangle state_rec = split_rectangle_vertically(layout->sequencer_state_section, i, SEQUENCER_AMOUNT);
+        layout->sequencer_states[i] = state_rec;
+
+        layout->sequencer_rows[i] = layout->sequencer;
+        layout->sequencer_rows[i].y = state_rec.y;
+        layout->sequencer_rows[i].height = state_rec.height;
+
+        for (int section = 0; section < SEQUENCER_SECTION_COUNT; section++) {
+            layout->sequencer_state_sections[i][section] = split_rectangle_vertically(state_rec, section, SEQUENCER_SECTION_COUNT);
+        }
+    }
+
+    for (int i = 0; i < SEQUENCER_ELEMENTS; i++) {
+        Rectangle element_rec = {
+            .x = layout->sequencer.x + (element_width * (i % SEQUENCER_ROW)),
+            .y = layout->sequencer.y + (layout->sequencer_element_height * (i / SEQUENCER_ROW)),
+            .width = element_width,
+            .height = layout->sequencer_element_height,
+        };
+        layout->sequencer_elements[i] = element_rec;
+
+        for (int section = 0; section < SEQUENCER_SECTION_COUNT; section++) {
+            layout->sequencer_element_sections[i][section] = split_rectangle_vertically(element_rec, section, SEQUENCER_SECTION_COUNT);
+        }
+    }
+
+    for (int i = 0; i < CONTROLS_COUNT; i++) {
+        int x_idx = i / CONTROLS_COLUMN_COUNT;
+        int y_idx = i % CONTROLS_COLUMN_COUNT;
+        Rectangle rec = {
+            .x = (width / 2) * x_idx,
+            .y = (thing_height * VERTICAL_POSITION_OF_CONTROLS) + (thing_height * y_idx),
+            .width = width / 2,
+            .height = thing_height,
+        };
+        layout->controls[i] = rec;
+        layout->control_labels[i] = split_rectangle_horizontally(rec, 0, 2);
+        layout->control_values[i] = split_rectangle_horizontally(rec, 1, 2);
+    }
 }
 
-Rectangle get_control_label_rectangle(int control) {
-    Rectangle rec = get_control_rectangle(control);
-    rec.width /= 2;
-    return rec;
+inline static Rectangle get_load_file_rectangle() {
+    return state->layout.load_file;
 }
 
-Rectangle get_control_value_rectangle(int control) {
-    Rectangle rec = get_control_rectangle(control);
-    rec.x = rec.x + (rec.width / 2);
-    rec.width /= 2;
-    return rec;
+inline static Rectangle get_save_file_rectangle() {
+    return state->layout.save_file;
 }
 
-Rectangle get_play_button_rectangle() {
-    float height = get_thing_height();
-    return (Rectangle) {
-        .x = 0,
-        .y = height * VERTICAL_POSITION_OF_PLAY_BUTTON,
-        .width = GetScreenWidth(),
-        .height = height,
-    };
+inline static Rectangle get_control_rectangle(int control) {
+    return state->layout.controls[control];
 }
 
-inline static float get_sequencer_element_width() {
-    return (float)(GetScreenWidth()) / ((float)SEQUENCER_ROW + 1.0f);
+inline static Rectangle get_control_label_rectangle(int control) {
+    return state->layout.control_labels[control];
 }
 
-Rectangle get_sequencer_rectangle() {
-    float element_width = get_sequencer_element_width();
-    float height = get_thing_height();
-    Rectangle rec;
-    rec.x = element_width;
-    rec.width = element_width * SEQUENCER_ROW;
-    rec.y = height * VERTICAL_POSITION_OF_SEQUENCER;
-    rec.height = height * SEQUENCER_ROWS;
-    return rec;
+inline static Rectangle get_control_value_rectangle(int control) {
+    return state->layout.control_values[control];
 }
 
-Rectangle get_sequencer_state_section_rectangle() {
-    Rectangle rec = get_sequencer_rectangle();
-    rec.width /= SEQUENCER_ROW;
-    rec.x -= rec.width;
-    return rec;
+inline static Rectangle get_play_button_rectangle() {
+    return state->layout.play_button;
 }
 
-Rectangle get_sequencer_state_rectangle(int idx) {
-    Rectangle rec = get_sequencer_state_section_rectangle();
-    rec.height /= SEQUENCER_AMOUNT;
-    rec.y += (rec.height * idx);
-    return rec;
+inline static Rectangle get_sequencer_rectangle() {
+    return state->layout.sequencer;
 }
 
-Rectangle get_sequencer_element_rectangle(int idx) {
-    Rectangle sequencer_rec = get_sequencer_rectangle();
-    Rectangle element_rec;
-    element_rec.width = sequencer_rec.width / SEQUENCER_ROW;
-    element_rec.height = sequencer_rec.height / SEQUENCER_AMOUNT;
-    element_rec.x = sequencer_rec.x + (element_rec.width * (idx % SEQUENCER_ROW));
-    element_rec.y = sequencer_rec.y + (element_rec.height * (idx / SEQUENCER_ROW));
-    return element_rec;
-}
-
-Rectangle get_sequencer_section_rectangle(Rectangle element_rec, int section) {
-    element_rec.height /= 3;
-    switch (section) {
-        case SEQUENCER_ELEMENT_SECTION_CHORD_SYMBOL:
-            break;
-        case SEQUENCER_ELEMENT_SECTION_BUTTON:
-            element_rec.y += element_rec.height;
-            break;
-        case SEQUENCER_ELEMENT_SECTION_CURSOR:
-            element_rec.y += (element_rec.height * 2);
-            break;
-    }
+inline static Rectangle get_sequencer_row_rectangle(int idx) {
+    return state->layout.sequencer_rows[idx];
+}
 
-    return element_rec;
+inline static Rectangle get_sequencer_state_section_rectangle() {
+    return state->layout.sequencer_state_section;
 }
 
-Rectangle get_cmd_rectangle() {
-    float height = get_thing_height();
-    return (Rectangle) {
-        .x = 0,
-        .y = height * VERTICAL_POSITION_OF_CMD,
-        .width = GetScreenWidth(),
-        .height = height,
-    };
+inline static Rectangle get_sequencer_state_rectangle(int idx) {
+    return state->layout.sequencer_states[idx];
+}
+
+inline static Rectangle get_sequencer_state_button_rectangle(int idx, int section) {
+    return state->layout.sequencer_state_sections[idx][section];
+}
+
+inline static Rectangle get_sequencer_element_rectangle(int idx) {
+    return state->layout.sequencer_elements[idx];
+}
+
+inline static Rectangle get_sequencer_element_section_rectangle(int idx, int section) {
+    return state->layout.sequencer_element_sections[idx][section];
 }
 
+inline static Rectangle get_cmd_rectangle() {
+    return state->layout.cmd;
+}
+
+inline static int get_grid_index(float offset, float cell_size, int cell_count) {
+    int idx = offset / cell_size;
+    return (idx < cell_count) ? idx : cell_count - 1;
+}
+
+// returns the sequencer element under position (or -1) without
+// testing every element, the section within it goes to *section
+int get_sequencer_element_at(Vector2 position, int *section) {
+    Layout *layout = &state->layout;
+    float x = position.x - layout->sequencer.x;
+    float y = position.y - layout->sequencer.y;
+
+    if (x <= 0.0f || y <= 0.0f || x >= layout->sequencer.width || y >= layout->sequencer.height) {
+        return -1;
+    }
+
+    int column = get_grid_index(x, layout->sequencer_element_width, SEQUENCER_ROW);
+    int row = get_grid_index(y, layout->sequencer_element_height, SEQUENCER_AMOUNT);
+    float section_y = y - (row * layout->sequencer_element_height);
+    *section = get_grid_index(section_y, layout->sequencer_element_height / SEQUENCER_SECTION_COUNT, SEQUENCER_SECTION_COUNT);
+
+    return (row * SEQUENCER_ROW) + column;
+}
+
+// same as get_sequencer_element_at() but for the on/off + reset column
+int get_sequencer_state_at(Vector2 position, int *section) {
+    Layout *layout = &state->layout;
+    Rectangle rec = layout->sequencer_state_section;
+    float x = position.x - rec.x;
+    float y = position.y - rec.y;
+
+    if (x <= 0.0f || y <= 0.0f || x >= rec.width || y >= rec.height) {
+        return -1;
+    }
+
+    int row = get_grid_index(y, layout->sequencer_element_height, SEQUENCER_AMOUNT);
+    float section_y = y - (row * layout->sequencer_element_height);
+    *section = get_grid_index(section_y, layout->sequencer_element_height / SEQUENCER_SECTION_COUNT, SEQUENCER_SECTION_COUNT);
+
+    return row;
+}
@@ -1,21 +1,68 @@
+// lines and triangles go out as quads on the shapes texture, like
+// DrawRectangleRec does, so the solid shapes of a frame stay one draw call.
+// raylib's own draw them as triangles, every switch between the two starts
+// a new one. counter clockwise on screen or they get culled
+static void draw_quad(Vector2 v1, Vector2 v2, Vector2 v3, Vector2 v4, Color color) {
+    Texture2D texture = GetShapesTexture();
+    Rectangle source = GetShapesTextureRectangle();
+    float left = source.x / texture.width;
+    float top = source.y / texture.height;
+    float right = (source.x + source.width) / texture.width;
+    float bottom = (source.y + source.height) / texture.height;
+
+    rlSetTexture(texture.id);
+    rlBegin(RL_QUADS);
+    rlNormal3f(0.0f, 0.0f, 1.0f);
+    rlColor4ub(color.r, color.g, color.b, color.a);
+    rlTexCoord2f(left, top);
+    rlVertex2f(v1.x, v1.y);
+    rlTexCoord2f(left, bottom);
+    rlVertex2f(v2.x, v2.y);
+    rlTexCoord2f(right, bottom);
+    rlVertex2f(v3.x, v3.y);
+    rlTexCoord2f(right, top);
+    rlVertex2f(v4.x, v4.y);
+    rlEnd();
+    rlSetTexture(0);
+}
+
+void draw_line(Vector2 start, Vector2 end, float thickness, Color color) {
+    float dx = end.x - start.x;
+    float dy = end.y - start.y;
+    float length = sqrtf((dx * dx) + (dy * dy));
+    if (length == 0.0f) {
+        return;
+    }
+    Vector2 normal = { -dy * thickness / (2 * length), dx * thickness / (2 * length) };
+    Vector2 v1 = { start.x - normal.x, start.y - normal.y };
+    Vector2 v2 = { start.x + normal.x, start.y + normal.y };
+    Vector2 v3 = { end.x + normal.x, end.y + normal.y };
+    Vector2 v4 = { end.x - normal.x, end.y - normal.y };
+    draw_quad(v1, v2, v3, v4, color);
+}
+
+void draw_triangle(Vector2 v1, Vector2 v2, Vector2 v3, Color color) {
+    draw_quad(v1, v2, v3, v3, color);
+}
+
 void draw_separator(Rectangle rec) {
     Vector2 start = { rec.x, rec.y + rec.height };
     Vector2 end = { rec.x + rec.width, start.y };
-    DrawLineEx(start, end, size_multiplier() * 0.002f, TP_BG2);
+    draw_line(start, end, size_multiplier() * 0.002f, TP_BG2);
 }
 
 void draw_text_in_rectangle(Rectangle rec, const char *text, Color color) {
     Vector2 position = { rec.x + rec.width / 2, rec.y + rec.height / 2 };
-    Vector2 dimensions = MeasureTextEx(state->font, text, font_size(), state->font_spacing);
+    Vector2 dimensions = measure_text(text);
     Vector2 origin = { dimensions.x / 2, dimensions.y / 2 };
-    DrawTextPro(state->font, text, position, origin, 0, font_size(), state->font_spacing, color);
+    draw_text(text, position, origin, color);
 }
 
 void draw_text_in_rectangle_fixed_x(Rectangle rec, const char *text, Color color) {
     Vector2 position = { rec.x, rec.y + rec.height / 2 };
-    Vector2 dimensions = MeasureTextEx(state->font, text, font_size(), state->font_spacing);
+    Vector2 dimensions = measure_text(text);
     Vector2 origin = { -(0.01f * size_multiplier()), dimensions.y / 2 };
-    DrawTextPro(state->font, text, position, origin, 0, font_size(), state->font_spacing, color);
+    draw_text(text, position, origin, color);
 }
 
 void draw_load_file_button() {
@@ -32,7 +79,7 @@ void draw_save_file_button() {
 
 void draw_play_control() {
     Rectangle rec = get_play_button_rectangle();
-    if (has_flag(FLAG_PLAYING)) {
+    if (state->engine.playing) {
         DrawRectangleRec(rec, TP_GREEN);
         draw_text_in_rectangle(rec, "Playing", TP_FG);
     } else {
@@ -73,31 +120,31 @@ void draw_controls() {
         switch (i) {
             case CONTROLS_SCALE: {
                 label_text = "Scale";
-                draw_control(value_rec, get_scale_name(state->scale_type));
+                draw_control(value_rec, get_scale_name(state->engine.scale_type));
             } break;
             case CONTROLS_ROOT_NOTE: {
                 label_text = "Root Note";
-                draw_control(value_rec, get_note_name(state->scale_root));
+                draw_control(value_rec, get_note_name(state->engine.scale_root));
             } break;
             case CONTROLS_VIBE: {
                 label_text = "Vibe";
-                draw_control(value_rec, get_vibe_name(state->vibe));
+                draw_control(value_rec, get_vibe_name(state->engine.vibe));
             } break;
             case CONTROLS_VIBES_PER_CHORD: {
                 label_text = "Vibes/chord";
-                draw_control(value_rec, TextFormat("%d", state->vibes_per_chord));
+                draw_control(value_rec, TextFormat("%d", state->engine.vibes_per_chord));
             } break;
             case CONTROLS_ACCIDENTAL: {
                 label_text = "Accidentals";
-                draw_toggle_control(value_rec, !has_flag(FLAG_FLATS), "Sharps(♯)", "Flats(♭)");
+                draw_toggle_control(value_rec, !state->engine.flats, "Sharps(♯)", "Flats(♭)");
             } break;
             case CONTROLS_VOLUME: {
                 label_text = "Volume";
-                draw_slider_control(value_rec, 0.0f, 1.0f, state->volume_manual);
+                draw_slider_control(value_rec, 0.0f, 1.0f, state->engine.volume_manual);
             } break;
             case CONTROLS_INTERVAL: {
                 label_text = "Time/chord";
-                draw_slider_control(value_rec, state->min_time_per_chord, state->max_time_per_chord, state->time_per_chord);
+                draw_slider_control(value_rec, state->engine.min_time_per_chord, state->engine.max_time_per_chord, state->engine.time_per_chord);
             } break;
         }
 
@@ -110,22 +157,15 @@ void draw_controls() {
 }
 
 void draw_sequencer() {
-    Rectangle sequencer_rec = get_sequencer_rectangle();
-
     for (int i = 0; i < SEQUENCER_AMOUNT; i++) {
-        Rectangle state_rec = get_sequencer_state_rectangle(i);
-        Rectangle sequencer_row_rec;
-        sequencer_row_rec.x = sequencer_rec.x;
-        sequencer_row_rec.y = state_rec.y;
-        sequencer_row_rec.width = sequencer_rec.width;
-        sequencer_row_rec.height = state_rec.height;
-
-        Rectangle reset_button_rec = get_sequencer_section_rectangle(state_rec, SEQUENCER_STATE_SECTION_RESET);
+        Rectangle sequencer_row_rec = get_sequencer_row_rectangle(i);
+
+        Rectangle reset_button_rec = get_sequencer_state_button_rectangle(i, SEQUENCER_STATE_SECTION_RESET);
         draw_text_in_rectangle(reset_button_rec, "RESET", TP_FG);
 
         const char *state_text;
         Color state_bg;
-        if (state->sequencer_states[i]) {
+        if (state->engine.sequencer_states[i]) {
             state_text = "ON";
             state_bg = TP_GREEN;
         } else {
@@ -133,32 +173,30 @@ void draw_sequencer() {
             state_bg = TP_RED;
         }
 
-        Rectangle state_button_rec = get_sequencer_section_rectangle(state_rec, SEQUENCER_STATE_SECTION_ENABLE);
+        Rectangle state_button_rec = get_sequencer_state_button_rectangle(i, SEQUENCER_STATE_SECTION_ENABLE);
         DrawRectangleRec(state_button_rec, state_bg);
         draw_text_in_rectangle(state_button_rec, state_text, TP_FG);
 
         Vector2 line_start = {state_button_rec.x + state_button_rec.width, state_button_rec.y + (state_button_rec.height / 2) };
         Vector2 line_end = {sequencer_row_rec.x + sequencer_row_rec.width, line_start.y };
-        DrawLineEx(line_start, line_end, size_multiplier() * 0.004f, state_bg);
+        draw_line(line_start, line_end, size_multiplier() * 0.004f, state_bg);
 
         for (int j = 0; j < SEQUENCER_ROW; j++) {
             int element_idx = (i * SEQUENCER_ROW) + j;
 
-            Rectangle element_rec = get_sequencer_element_rectangle(element_idx);
-
-            Chord chord = get_sequencer_chord(state->sequencer[element_idx]);
+            Chord chord = get_sequencer_chord(&state->engine, state->engine.sequencer[element_idx]);
             bool is_enabled = chord.type != CHORD_TYPE_NONE;
 
-            Rectangle chord_symbol_rec = get_sequencer_section_rectangle(element_rec, SEQUENCER_ELEMENT_SECTION_CHORD_SYMBOL);
+            Rectangle chord_symbol_rec = get_sequencer_element_section_rectangle(element_idx, SEQUENCER_ELEMENT_SECTION_CHORD_SYMBOL);
             const char *chord_symbol = is_enabled ? chord.symbol : "---";
             draw_text_in_rectangle(chord_symbol_rec, chord_symbol, TP_FG);
 
-            Rectangle button_rec = get_sequencer_section_rectangle(element_rec, SEQUENCER_ELEMENT_SECTION_BUTTON);
+            Rectangle button_rec = get_sequencer_element_section_rectangle(element_idx, SEQUENCER_ELEMENT_SECTION_BUTTON);
 
             const char *button_text = is_enabled ? chord.roman : "off";
             Color button_bg = TP_BG2;
             if (is_enabled) {
-                if (state->sequencer_states[i]) {
+                if (state->engine.sequencer_states[i]) {
                     button_bg = TP_GREEN;
                 } else if (is_enabled) {
                     button_bg = TP_RED;
@@ -167,17 +205,17 @@ void draw_sequencer() {
 
             DrawRectangleRec(button_rec, button_bg);
             draw_text_in_rectangle(button_rec, button_text, TP_FG);
-            Rectangle cursor_rec = get_sequencer_section_rectangle(element_rec, SEQUENCER_ELEMENT_SECTION_CURSOR);
+            Rectangle cursor_rec = get_sequencer_element_section_rectangle(element_idx, SEQUENCER_ELEMENT_SECTION_CURSOR);
 
-            if (element_idx == state->chord_idx) {
-                float cursor_offset = ((state->chord_timer / state->time_per_chord) * button_rec.width);
+            if (element_idx == state->engine.chord_idx) {
+                float cursor_offset = ((state->engine.chord_timer / state->engine.time_per_chord) * button_rec.width);
                 float cursor_size = cursor_rec.height / 4;
 
                 Vector2 v1 = { cursor_rec.x + cursor_offset, cursor_rec.y };
                 Vector2 v2 = { v1.x, v1.y + cursor_rec.height };
                 Vector2 v3 = { v1.x + cursor_size, v1.y + cursor_rec.height / 2 };
 
-                DrawTriangle(v1, v2, v3, state_bg);
+                draw_triangle(v1, v2, v3, state_bg);
             }
         }
 
@@ -190,21 +228,53 @@ void draw_cmd() {
     DrawRectangleRec(rec, TP_BG2);
     switch (state->state) {
         case STATE_MAIN: {
-            draw_text_in_rectangle_fixed_x(
-                rec,
-                TextFormat(
-                    "sequencer: %i:%i (%.2fs/%.2fs)",
-                    1 + (state->chord_idx / SEQUENCER_ROW),
-                    1 + (state->chord_idx % SEQUENCER_ROW),
-                    state->chord_timer,
-                    state->time_per_chord
-                ),
-                TP_FG
+            const char *text = TextFormat(
+                "sequencer: %i:%i (%.2fs/%.2fs)",
+                1 + (state->engine.chord_idx / SEQUENCER_ROW),
+                1 + (state->engine.chord_idx % SEQUENCER_ROW),
+                state->engine.chord_timer,
+                state->engine.time_per_chord
             );
+            if (state->engine.use_pcm_cache) {
+                text = TextFormat(
+                    "%s cache: %i bars %.1fMB",
+                    text,
+                    atomic_load(&state->engine.pcm_cache.ready_count),
+                    atomic_load(&state->engine.pcm_cache.bytes) / (1024.0f * 1024.0f)
+                );
+            }
+            if (state->recorder.started) {
+                uint64 seconds = atomic_load(&state->recorder.written) / SAMPLE_RATE;
+                text = TextFormat("%s rec %i:%02i", text, (int)(seconds / 60), (int)(seconds % 60));
+            }
+            uint8 midi_out_mode = atomic_load(&state->midi_out.mode);
+            if (midi_out_mode != MIDI_OUT_MODE_OFF) {
+                text = TextFormat("%s %s", text, (midi_out_mode == MIDI_OUT_MODE_ONLY) ? "midi only" : "midi out");
+            }
+            if (state->midi_in.started) {
+                text = TextFormat("%s midi in", text);
+            }
+            uint32 soft_assert_count = get_soft_assert_count();
+            if (soft_assert_count > 0) {
+                text = TextFormat("%s asserts %u", text, soft_assert_count);
+            }
+            if (atomic_load(&state->exporter.running)) {
+                text = TextFormat("%s exporting %i/%i", text, atomic_load(&state->exporter.done_count), EXPORT_JOB_COUNT);
+            }
+            draw_text_in_rectangle_fixed_x(rec, text, TP_FG);
         } break;
         case STATE_SAVE_FILE: {
             draw_text_in_rectangle_fixed_x(rec, TextFormat("save to file: \"%s\"", state->cmd_buffer), TP_FG);
-        }
+        } break;
+        case STATE_LOAD_FILE: {
+            draw_text_in_rectangle_fixed_x(rec, TextFormat("load midi file: \"%s.mid\"", state->cmd_buffer), TP_FG);
+        } break;
+        case STATE_RESTORE: {
+            draw_text_in_rectangle_fixed_x(rec, "the last session did not end well, restore it? (y/n)", TP_FG);
+        } break;
+        case STATE_MESSAGE: {
+            draw_text_in_rectangle_fixed_x(rec, TextFormat("%s (enter)", state->cmd_message), TP_FG);
+        } break;
     }
 }
 
@@ -227,8 +297,274 @@ void draw_selectables() {
         const char *text = state->selectables.items[i];
         DrawRectangleRec(rec, bg_color);
         Vector2 position = { rec.x + item_height / 4, rec.y + rec.height / 2 };
-        Vector2 dimensions = MeasureTextEx(state->font, text, font_size(), state->font_spacing);
+        Vector2 dimensions = measure_text(text);
         Vector2 origin = { 0, dimensions.y / 2 };
-        DrawTextPro(state->font, text, position, origin, 0, font_size(), state->font_spacing, TP_FG);
+        draw_text(text, position, origin, TP_FG);
+    }
+}
+
+#define PROFILER_GRAPH_MAX_TIME (1.0f / 30.0f)
+#define PROFILER_GRAPH_ROWS 4
+
+static Color profile_section_colors[PROFILE_SECTION_COUNT] = {
+    [PROFILE_SECTION_UPDATE] = SKYBLUE,
+    [PROFILE_SECTION_DRAW_SEQUENCER] = ORANGE,
+    [PROFILE_SECTION_DRAW_CONTROLS] = LIME,
+    [PROFILE_SECTION_DRAW_OTHER] = VIOLET,
+    [PROFILE_SECTION_END_DRAWING] = GRAY,
+    [PROFILE_SECTION_TEXT] = GOLD,
+};
+
+void draw_profiler() {
+    float row_height = get_thing_height();
+    Rectangle rec = {
+        .x = state->layout.screen_width / 2,
+        .y = 0,
+        .width = state->layout.screen_width / 2,
+        .height = row_height * (PROFILER_GRAPH_ROWS + PROFILE_SECTION_COUNT + 1),
+    };
+    DrawRectangleRec(rec, Fade(TP_BG2, 0.9f));
+
+    Rectangle graph = rec;
+    graph.height = row_height * PROFILER_GRAPH_ROWS;
+    float bar_width = graph.width / PROFILE_FRAME_COUNT;
+    float scale = graph.height / PROFILER_GRAPH_MAX_TIME;
+
+    // newest frame on the right, sections stacked bottom up
+    int count = state->profiler.frame_count - 1;
+    for (int i = 1; i <= count; i++) {
+        ProfileFrame *frame = get_profile_frame(i);
+        float x = graph.x + graph.width - (bar_width * i);
+        float y = graph.y + graph.height;
+        for (int j = 0; j < PROFILE_SECTION_STACKED_COUNT; j++) {
+            float height = frame->section_time[j] * scale;
+            y -= height;
+            DrawRectangleRec((Rectangle){ x, y, bar_width, height }, profile_section_colors[j]);
+        }
+    }
+
+    float budget_y = graph.y + graph.height - ((1.0f / 60.0f) * scale);
+    Vector2 budget_start = { graph.x, budget_y };
+    Vector2 budget_end = { graph.x + graph.width, budget_y };
+    draw_line(budget_start, budget_end, size_multiplier() * 0.002f, TP_FG);
+
+    for (int i = 0; i < PROFILE_SECTION_COUNT; i++) {
+        Rectangle row = {
+            .x = rec.x,
+            .y = graph.y + graph.height + (row_height * i),
+            .width = rec.width,
+            .height = row_height,
+        };
+        double p50, p99;
+        get_profile_percentiles(i, &p50, &p99);
+        draw_text_in_rectangle_fixed_x(
+            row,
+            TextFormat("%s p50 %.2fms p99 %.2fms", get_profile_section_name(i), p50 * 1000.0, p99 * 1000.0),
+            profile_section_colors[i]
+        );
+    }
+
+    // the frame before, this one is still being drawn
+    if (state->profiler.frame_count > 1) {
+        ProfileFrame *frame = get_profile_frame(1);
+        Rectangle row = {
+            .x = rec.x,
+            .y = graph.y + graph.height + (row_height * PROFILE_SECTION_COUNT),
+            .width = rec.width,
+            .height = row_height,
+        };
+        draw_text_in_rectangle_fixed_x(
+            row,
+            TextFormat("gpu %u draw calls %u vertices %u flushes", frame->draw_calls, frame->vertices, frame->batch_flushes),
+            TP_FG
+        );
+    }
+}
+
+// first rising zero crossing that still leaves a full span after it,
+// so the waveform stands still on screen instead of scrolling
+static int find_oscilloscope_trigger(const int16 *window) {
+    for (int i = 1; i < OSCILLOSCOPE_WINDOW - OSCILLOSCOPE_SPAN; i++) {
+        if (window[i - 1] < 0 && window[i] >= 0) {
+            return i;
+        }
+    }
+    return 0;
+}
+
+// the visualisers cover the sequencer, sharing it when both are on
+static Rectangle get_visualizer_rectangle(int flag) {
+    Rectangle rec = get_sequencer_rectangle();
+    if (has_flag(FLAG_OSCILLOSCOPE) && has_flag(FLAG_SPECTRUM)) {
+        return split_rectangle_vertically(rec, (flag == FLAG_SPECTRUM) ? 1 : 0, 2);
+    }
+    return rec;
+}
+
+void draw_oscilloscope() {
+    Rectangle rec = get_visualizer_rectangle(FLAG_OSCILLOSCOPE);
+    DrawRectangleRec(rec, Fade(TP_BG2, 0.9f));
+
+    int16 *window = state->oscilloscope_window;
+    audio_tap_read(&state->audio_tap, window, OSCILLOSCOPE_WINDOW);
+    int trigger = find_oscilloscope_trigger(window);
+
+    int point_count = (int)rec.width;
+    if (point_count > OSCILLOSCOPE_POINT_CAPACITY) {
+        point_count = OSCILLOSCOPE_POINT_CAPACITY;
+    }
+    if (point_count < 2) {
+        return;
+    }
+
+    // one point per pixel column, the span is decimated to fit
+    Vector2 *points = state->oscilloscope_points;
+    float step = (float)OSCILLOSCOPE_SPAN / point_count;
+    float center_y = rec.y + (rec.height / 2);
+    float scale = (rec.height / 2) / 32768.0f;
+    for (int i = 0; i < point_count; i++) {
+        int16 sample = window[trigger + (int)(i * step)];
+        points[i].x = rec.x + i;
+        points[i].y = center_y - (sample * scale);
+    }
+
+    DrawLineStrip(points, point_count, COLOR_CURSOR_CURRENT);
+}
+
+#define SPECTRUM_COLOR_ROOT ((Color){0xff, 0x60, 0x40, 0xff})
+#define SPECTRUM_COLOR_THIRD ((Color){0x40, 0xff, 0x60, 0xff})
+#define SPECTRUM_COLOR_FIFTH ((Color){0x40, 0xa0, 0xff, 0xff})
+#define SPECTRUM_COLOR_OTHER ((Color){0xd0, 0xc0, 0x90, 0x80})
+
+// loudest fft bin within a quarter tone of the semitone, falling back to the
+// nearest bin down low where a semitone is narrower than the fft resolution
+static float get_spectrum_semitone_power(int semitone) {
+    float resolution = (float)SAMPLE_RATE / FFT_SIZE;
+    float center = SPECTRUM_LOWEST_FREQ * powf(2.0f, semitone / 12.0f);
+    float quarter_tone = powf(2.0f, 1.0f / 24.0f);
+    int low = ceilf((center / quarter_tone) / resolution);
+    int high = floorf((center * quarter_tone) / resolution);
+
+    if (high > FFT_HALF) {
+        high = FFT_HALF;
+    }
+    if (low > high) {
+        low = high = (int)roundf(center / resolution);
+    }
+
+    float power = 0.0f;
+    for (int i = low; i <= high; i++) {
+        if (state->spectrum_power[i] > power) {
+            power = state->spectrum_power[i];
+        }
+    }
+    return power;
+}
+
+void draw_spectrum() {
+    Rectangle rec = get_visualizer_rectangle(FLAG_SPECTRUM);
+    DrawRectangleRec(rec, Fade(TP_BG2, 0.9f));
+
+    profile_begin(PROFILE_SECTION_FFT);
+    audio_tap_read(&state->audio_tap, state->spectrum_samples, FFT_SIZE);
+    for (int i = 0; i < FFT_SIZE; i++) {
+        state->spectrum_input[i] = state->spectrum_samples[i] / 32768.0f;
     }
+    fft_power_spectrum(&state->fft, state->spectrum_input, state->spectrum_power);
+    profile_end(PROFILE_SECTION_FFT);
+
+    Chord chord = { .type = CHORD_TYPE_NONE };
+    if (state->engine.playing) {
+        chord = get_sequencer_chord(&state->engine, state->engine.sequencer[state->engine.chord_idx]);
+    }
+
+    // a full scale sine lands at (FFT_SIZE / 4)^2 with the hann window
+    float full_scale = (FFT_SIZE / 4.0f) * (FFT_SIZE / 4.0f);
+    float bar_width = rec.width / SPECTRUM_BIN_COUNT;
+
+    for (int i = 0; i < SPECTRUM_BIN_COUNT; i++) {
+        float db = 10.0f * log10f((get_spectrum_semitone_power(i) / full_scale) + 1e-12f);
+        float level = 1.0f - (db / SPECTRUM_MIN_DB);
+        if (level < 0.0f) {
+            level = 0.0f;
+        } else if (level > 1.0f) {
+            level = 1.0f;
+        }
+
+        int pitch_class = (NOTE_A + i) % NOTE_COUNT;
+        Color color = SPECTRUM_COLOR_OTHER;
+        if (chord.type != CHORD_TYPE_NONE) {
+            if (pitch_class == chord.root) {
+                color = SPECTRUM_COLOR_ROOT;
+            } else if (pitch_class == chord.third) {
+                color = SPECTRUM_COLOR_THIRD;
+            } else if (pitch_class == chord.fifth) {
+                color = SPECTRUM_COLOR_FIFTH;
+            }
+        }
+
+        float height = level * rec.height;
+        Rectangle bar = {
+            .x = rec.x + (bar_width * i),
+            .y = rec.y + rec.height - height,
+            .width = bar_width - 1.0f,
+            .height = height,
+        };
+        DrawRectangleRec(bar, color);
+    }
+
+    Rectangle legend = rec;
+    legend.height = get_thing_height();
+    draw_text_in_rectangle_fixed_x(split_rectangle_horizontally(legend, 0, 3), "root", SPECTRUM_COLOR_ROOT);
+    draw_text_in_rectangle_fixed_x(split_rectangle_horizontally(legend, 1, 3), "third", SPECTRUM_COLOR_THIRD);
+    draw_text_in_rectangle_fixed_x(split_rectangle_horizontally(legend, 2, 3), "fifth", SPECTRUM_COLOR_FIFTH);
+}
+
+// everything on screen, into whatever is the render target. shapes are
+// drawn as they come and the text of a layer after all of them, so each
+// layer is one batch of shapes and one of text
+void draw_frame() {
+    draw_batch_begin();
+    ClearBackground(TP_BG);
+
+    profile_begin(PROFILE_SECTION_DRAW_OTHER);
+    draw_load_file_button();
+    draw_save_file_button();
+    profile_end(PROFILE_SECTION_DRAW_OTHER);
+
+    profile_begin(PROFILE_SECTION_DRAW_SEQUENCER);
+    draw_sequencer();
+    profile_end(PROFILE_SECTION_DRAW_SEQUENCER);
+
+    profile_begin(PROFILE_SECTION_DRAW_OTHER);
+    draw_play_control();
+    profile_end(PROFILE_SECTION_DRAW_OTHER);
+
+    profile_begin(PROFILE_SECTION_DRAW_CONTROLS);
+    draw_controls();
+    profile_end(PROFILE_SECTION_DRAW_CONTROLS);
+
+    profile_begin(PROFILE_SECTION_DRAW_OTHER);
+    draw_cmd();
+    draw_queued_text();
+    if (state->state == STATE_SELECT) {
+        draw_selectables();
+        draw_queued_text();
+    }
+    profile_end(PROFILE_SECTION_DRAW_OTHER);
+
+    if (has_flag(FLAG_OSCILLOSCOPE)) {
+        draw_oscilloscope();
+        draw_queued_text();
+    }
+    if (has_flag(FLAG_SPECTRUM)) {
+        draw_spectrum();
+        draw_queued_text();
+    }
+    if (has_flag(FLAG_PROFILER)) {
+        draw_profiler();
+        draw_queued_text();
+    }
+
+    draw_batch_end();
 }
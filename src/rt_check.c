@@ -0,0 +1,268 @@
+// debug builds on linux check that the audio callback stays real time safe.
+// the allocator, mutex locking and output (write, fwrite, puts and the printf
+// family, with the _chk versions fortified libraries call) are interposed,
+// any call to them while the audio thread is inside the callback is kept
+// with a backtrace in a fixed table. the ui thread prints them once playback
+// stops
+
+#if defined(DEBUG) && defined(__linux__)
+
+#include <dlfcn.h>
+#include <execinfo.h>
+#include <stdarg.h>
+#include <unistd.h>
+
+// glibc's own allocator entry points, so the wrappers need no lookup
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t count, size_t size);
+extern void *__libc_realloc(void *ptr, size_t size);
+extern void __libc_free(void *ptr);
+
+static _Thread_local bool rt_check_inside;
+static RtViolation rt_violations[RT_CHECK_MAX_VIOLATIONS];
+static _Atomic uint32 rt_violation_count;
+static uint32 rt_violations_reported;
+
+static int (*rt_real_pthread_mutex_lock)(pthread_mutex_t *mutex);
+static ssize_t (*rt_real_write)(int fd, const void *buffer, size_t count);
+static size_t (*rt_real_fwrite)(const void *buffer, size_t size, size_t count, FILE *file);
+static int (*rt_real_puts)(const char *text);
+static int (*rt_real_vprintf)(const char *format, va_list args);
+static int (*rt_real_vfprintf)(FILE *file, const char *format, va_list args);
+static int (*rt_real_vprintf_chk)(int flag, const char *format, va_list args);
+static int (*rt_real_vfprintf_chk)(FILE *file, int flag, const char *format, va_list args);
+
+static const char *get_rt_violation_name(int kind) {
+    switch (kind) {
+        case RT_VIOLATION_ALLOC: return "allocation";
+        case RT_VIOLATION_FREE: return "free";
+        case RT_VIOLATION_LOCK: return "mutex lock";
+        case RT_VIOLATION_IO: return "i/o";
+    }
+    return "?";
+}
+
+// the flag is dropped while recording, so whatever backtrace() calls
+// does not end up in here again
+static void rt_check_violation(int kind) {
+    rt_check_inside = false;
+    uint32 idx = atomic_fetch_add_explicit(&rt_violation_count, 1, memory_order_relaxed);
+    if (idx < RT_CHECK_MAX_VIOLATIONS) {
+        RtViolation *violation = &rt_violations[idx];
+        violation->kind = kind;
+        violation->depth = backtrace(violation->frames, RT_CHECK_BACKTRACE_DEPTH);
+        atomic_store_explicit(&violation->written, true, memory_order_release);
+    }
+    rt_check_inside = true;
+}
+
+static void *rt_check_resolve(const char *name) {
+    void *function = dlsym(RTLD_NEXT, name);
+    if (function == NULL) {
+        abort();
+    }
+    return function;
+}
+
+void *malloc(size_t size) {
+    if (rt_check_inside) {
+        rt_check_violation(RT_VIOLATION_ALLOC);
+    }
+    return __libc_malloc(size);
+}
+
+void *calloc(size_t count, size_t size) {
+    if (rt_check_inside) {
+        rt_check_violation(RT_VIOLATION_ALLOC);
+    }
+    return __libc_calloc(count, size);
+}
+
+void *realloc(void *ptr, size_t size) {
+    if (rt_check_inside) {
+        rt_check_violation(RT_VIOLATION_ALLOC);
+    }
+    return __libc_realloc(ptr, size);
+}
+
+void free(void *ptr) {
+    if (rt_check_inside && ptr != NULL) {
+        rt_check_violation(RT_VIOLATION_FREE);
+    }
+    __libc_free(ptr);
+}
+
+// the real functions are looked up on first use, things get locked and
+// printed long before init() runs
+int pthread_mutex_lock(pthread_mutex_t *mutex) {
+    if (rt_check_inside) {
+        rt_check_violation(RT_VIOLATION_LOCK);
+    }
+    if (rt_real_pthread_mutex_lock == NULL) {
+        rt_real_pthread_mutex_lock = rt_check_resolve("pthread_mutex_lock");
+    }
+    return rt_real_pthread_mutex_lock(mutex);
+}
+
+ssize_t write(int fd, const void *buffer, size_t count) {
+    if (rt_check_inside) {
+        rt_check_violation(RT_VIOLATION_IO);
+    }
+    if (rt_real_write == NULL) {
+        rt_real_write = rt_check_resolve("write");
+    }
+    return rt_real_write(fd, buffer, count);
+}
+
+size_t fwrite(const void *buffer, size_t size, size_t count, FILE *file) {
+    if (rt_check_inside) {
+        rt_check_violation(RT_VIOLATION_IO);
+    }
+    if (rt_real_fwrite == NULL) {
+        rt_real_fwrite = rt_check_resolve("fwrite");
+    }
+    return rt_real_fwrite(buffer, size, count, file);
+}
+
+int puts(const char *text) {
+    if (rt_check_inside) {
+        rt_check_violation(RT_VIOLATION_IO);
+    }
+    if (rt_real_puts == NULL) {
+        rt_real_puts = rt_check_resolve("puts");
+    }
+    return rt_real_puts(text);
+}
+
+
+int vprintf(const char *format, va_list args) {
+    if (rt_check_inside) {
+        rt_check_violation(RT_VIOLATION_IO);
+    }
+    if (rt_real_vprintf == NULL) {
+        rt_real_vprintf = rt_check_resolve("vprintf");
+    }
+    return rt_real_vprintf(format, args);
+}
+
+int printf(const char *format, ...) {
+    va_list args;
+    va_start(args, format);
+    int result = vprintf(format, args);
+    va_end(args);
+    return result;
+}
+
+int vfprintf(FILE *file, const char *format, va_list args) {
+    if (rt_check_inside) {
+        rt_check_violation(RT_VIOLATION_IO);
+    }
+    if (rt_real_vfprintf == NULL) {
+        rt_real_vfprintf = rt_check_resolve("vfprintf");
+    }
+    return rt_real_vfprintf(file, format, args);
+}
+
+int fprintf(FILE *file, const char *format, ...) {
+    va_list args;
+    va_start(args, format);
+    int result = vfprintf(file, format, args);
+    va_end(args);
+    return result;
+}
+
+// what printf and fprintf turn into in libraries built with
+// _FORTIFY_SOURCE
+int __vprintf_chk(int flag, const char *format, va_list args) {
+    if (rt_check_inside) {
+        rt_check_violation(RT_VIOLATION_IO);
+    }
+    if (rt_real_vprintf_chk == NULL) {
+        rt_real_vprintf_chk = rt_check_resolve("__vprintf_chk");
+    }
+    return rt_real_vprintf_chk(flag, format, args);
+}
+
+int __vfprintf_chk(FILE *file, int flag, const char *format, va_list args) {
+    if (rt_check_inside) {
+        rt_check_violation(RT_VIOLATION_IO);
+    }
+    if (rt_real_vfprintf_chk == NULL) {
+        rt_real_vfprintf_chk = rt_check_resolve("__vfprintf_chk");
+    }
+    return rt_real_vfprintf_chk(file, flag, format, args);
+}
+
+int __printf_chk(int flag, const char *format, ...) {
+    va_list args;
+    va_start(args, format);
+    int result = __vprintf_chk(flag, format, args);
+    va_end(args);
+    return result;
+}
+
+int __fprintf_chk(FILE *file, int flag, const char *format, ...) {
+    va_list args;
+    va_start(args, format);
+    int result = __vfprintf_chk(file, flag, format, args);
+    va_end(args);
+    return result;
+}
+
+// backtrace() loads libgcc the first time, that allocates
+void rt_check_init() {
+    void *frames[1];
+    backtrace(frames, 1);
+}
+
+inline static void rt_check_enter() {
+    rt_check_inside = true;
+}
+
+inline static void rt_check_leave() {
+    rt_check_inside = false;
+}
+
+// only prints what came in since the last report. a record the audio
+// thread is still writing stops it there, the next report starts from it
+void rt_check_report() {
+    uint32 count = atomic_load_explicit(&rt_violation_count, memory_order_relaxed);
+    uint32 recorded = (count < RT_CHECK_MAX_VIOLATIONS) ? count : RT_CHECK_MAX_VIOLATIONS;
+    uint32 ready = rt_violations_reported;
+    while (ready < recorded && atomic_load_explicit(&rt_violations[ready].written, memory_order_acquire)) {
+        ready++;
+    }
+    // the ones past the table have nothing to wait for once it is all out
+    uint32 reported = (ready == recorded) ? count : ready;
+    if (reported == rt_violations_reported) {
+        return;
+    }
+
+    printf("rt check: %u calls from the audio callback that can block\n", reported - rt_violations_reported);
+    for (uint32 i = rt_violations_reported; i < ready; i++) {
+        RtViolation *violation = &rt_violations[i];
+        printf(" -> %s\n", get_rt_violation_name(violation->kind));
+        fflush(stdout);
+        backtrace_symbols_fd(violation->frames, violation->depth, STDOUT_FILENO);
+    }
+    if (reported > RT_CHECK_MAX_VIOLATIONS) {
+        printf(" -> the rest did not fit, %u backtraces kept\n", RT_CHECK_MAX_VIOLATIONS);
+    }
+    rt_violations_reported = reported;
+}
+
+#else
+
+void rt_check_init() {
+}
+
+inline static void rt_check_enter() {
+}
+
+inline static void rt_check_leave() {
+}
+
+void rt_check_report() {
+}
+
+#endif
@@ -10,7 +10,7 @@ void prepare_select_state(int selectable_type, Vector2 position, uint8 *referenc
             Chord chord;
             state->selectables.item_count = SCALE_DEGREE_COUNT + 1;
             for (int i = 0; i < SCALE_DEGREE_COUNT; i++) {
-                Chord chord = get_sequencer_chord(i);
+                Chord chord = get_sequencer_chord(&state->engine, i);
                 const char *text = TextFormat("%s (%s)", chord.roman, chord.symbol);
                 TextCopy(state->selectables.items[i], text);
             }
@@ -46,8 +46,8 @@ void prepare_select_state(int selectable_type, Vector2 position, uint8 *referenc
             break;
     }
 
-    float screen_width = GetScreenWidth();
-    float screen_height = GetScreenHeight();
+    float screen_width = state->layout.screen_width;
+    float screen_height = state->layout.screen_height;
 
     state->selectables.rectangle.width = screen_width * SELECTABLES_BOX_WIDTH_MULTIPLIER;
 
@@ -0,0 +1,54 @@
+// the ui only publishes targets, the audio callback ramps towards them.
+// a block works out where the ramp will be at its end, so following it
+// costs one add per sample and the last sample lands exactly on it
+
+static const float param_ramp_times[PARAM_COUNT] = {
+    [PARAM_VOLUME] = 0.05f,
+    [PARAM_FADE] = 0.05f,
+    [PARAM_CUTOFF] = 0.1f,
+    [PARAM_TEMPO] = 0.5f,
+};
+
+void publish_param_targets(Engine *engine) {
+    atomic_store_explicit(&engine->param_targets[PARAM_VOLUME], engine->volume_manual, memory_order_relaxed);
+    atomic_store_explicit(&engine->param_targets[PARAM_FADE], engine->playing ? 1.0f : 0.0f, memory_order_relaxed);
+    atomic_store_explicit(&engine->param_targets[PARAM_CUTOFF], engine->filter_cutoff, memory_order_relaxed);
+    atomic_store_explicit(&engine->param_targets[PARAM_TEMPO], engine->time_per_chord, memory_order_relaxed);
+}
+
+void smoother_begin_block(Smoother *smoother, float target, float ramp_time, uint32 frames, float sample_rate) {
+    if (!smoother->primed) {
+        smoother->primed = true;
+        smoother->value = target;
+        smoother->target = target;
+        smoother->step = 0.0f;
+    }
+
+    if (target != smoother->target) {
+        float ramp_samples = ramp_time * sample_rate;
+        if (ramp_samples < 1.0f) {
+            ramp_samples = 1.0f;
+        }
+        smoother->target = target;
+        smoother->step = (target - smoother->value) / ramp_samples;
+    }
+
+    float remaining = smoother->target - smoother->value;
+    float block_delta = smoother->step * frames;
+    if (fabsf(block_delta) >= fabsf(remaining)) {
+        smoother->end = smoother->target;
+    } else {
+        smoother->end = smoother->value + block_delta;
+    }
+    smoother->increment = (frames > 0) ? (smoother->end - smoother->value) / frames : 0.0f;
+}
+
+inline static float smoother_next(Smoother *smoother) {
+    float value = smoother->value;
+    smoother->value += smoother->increment;
+    return value;
+}
+
+void smoother_end_block(Smoother *smoother) {
+    smoother->value = smoother->end;
+}
@@ -0,0 +1,231 @@
+#include <signal.h>
+
+// crash recovery. once a second the session goes into a memory mapped file,
+// if it changed. the file has two slots and a snapshot always goes over the
+// older one, so a crash in the middle of writing leaves the other one intact.
+// taking one is a memcpy, the os gets the pages to disk in its own time and
+// the crash handler forces it. a clean exit marks the file, the next launch
+// offers to restore only when that mark is missing
+
+#define SNAPSHOT_FILE "snapshot.bin"
+#define SNAPSHOT_MAGIC 0x534e5054 // "TPNS"
+#define SNAPSHOT_VERSION 1
+#define SNAPSHOT_INTERVAL 1.0
+#define SNAPSHOT_SLOT_COUNT 2
+
+// sequence is written last, a slot with a checksum that does not match
+// its data was being written when things went wrong
+typedef struct SnapshotSlot {
+    uint32 sequence;
+    uint32 checksum;
+    SnapshotData data;
+} SnapshotSlot;
+
+typedef struct SnapshotFile {
+    uint32 magic;
+    uint32 version;
+    uint32 clean_exit;
+    SnapshotSlot slots[SNAPSHOT_SLOT_COUNT];
+} SnapshotFile;
+
+// outside of state, the crash handler should not have to trust it
+static MappedFile snapshot_mapped_file;
+
+static const int snapshot_crash_signals[] = { SIGSEGV, SIGILL, SIGFPE, SIGABRT };
+
+static uint32 snapshot_checksum(const SnapshotData *data) {
+    const uint8 *bytes = (const uint8 *)data;
+    uint32 hash = 0x811c9dc5;
+    for (uint32 i = 0; i < sizeof(SnapshotData); i++) {
+        hash = (hash ^ bytes[i]) * 0x01000193;
+    }
+    return hash;
+}
+
+static SnapshotFile *get_snapshot_file() {
+    return (SnapshotFile *)snapshot_mapped_file.data;
+}
+
+// zeroed first so the padding between fields compares and hashes the same
+static void snapshot_take(SnapshotData *data) {
+    Engine *engine = &state->engine;
+    memset(data, 0, sizeof(SnapshotData));
+    data->scale_type = engine->scale_type;
+    data->scale_root = engine->scale_root;
+    data->vibe = engine->vibe;
+    data->vibes_per_chord = engine->vibes_per_chord;
+    data->flats = engine->flats;
+    data->time_per_chord = engine->time_per_chord;
+    data->volume_manual = engine->volume_manual;
+    data->filter_cutoff = engine->filter_cutoff;
+    data->filter_resonance = engine->filter_resonance;
+    data->filter_key_tracking = engine->filter_key_tracking;
+    memcpy(data->sequencer, engine->sequencer, sizeof(Sequencers));
+    memcpy(data->sequencer_states, engine->sequencer_states, sizeof(data->sequencer_states));
+}
+
+static bool snapshot_bool_valid(const bool *value) {
+    uint8 byte;
+    memcpy(&byte, value, 1);
+    return byte <= 1;
+}
+
+static bool snapshot_float_valid(float value, float min, float max) {
+    return isfinite(value) && value >= min && value <= max;
+}
+
+// the checksum only catches a torn write, a session that was already
+// scribbled over before it was taken checks out fine. anything used to
+// index a table has to be in range before it goes near the engine
+static bool snapshot_data_valid(const SnapshotData *data) {
+    if (data->scale_type >= SCALE_TYPE_COUNT || data->scale_root >= NOTE_COUNT || data->vibe >= VIBE_COUNT) {
+        return false;
+    }
+    // 1 to 16 in powers of two, as the selectable offers them
+    if (data->vibes_per_chord == 0 || data->vibes_per_chord > 16 || (data->vibes_per_chord & (data->vibes_per_chord - 1)) != 0) {
+        return false;
+    }
+    if (!snapshot_bool_valid(&data->flats)) {
+        return false;
+    }
+    if (
+        !isfinite(data->time_per_chord) || data->time_per_chord <= 0.0f ||
+        !snapshot_float_valid(data->volume_manual, 0.0f, 1.0f) ||
+        !snapshot_float_valid(data->filter_cutoff, 1.0f, SAMPLE_RATE / 2.0f) ||
+        !snapshot_float_valid(data->filter_resonance, 0.0f, 1.0f) ||
+        !snapshot_float_valid(data->filter_key_tracking, 0.0f, 1.0f)
+    ) {
+        return false;
+    }
+    for (int i = 0; i < SEQUENCER_ELEMENTS; i++) {
+        if (data->sequencer[i] > SCALE_DEGREE_NONE) {
+            return false;
+        }
+    }
+    for (int i = 0; i < SEQUENCER_AMOUNT; i++) {
+        if (!snapshot_bool_valid(&data->sequencer_states[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// the newest slot that is whole and makes sense, or NULL
+static const SnapshotSlot *get_latest_snapshot(const SnapshotFile *file) {
+    const SnapshotSlot *latest = NULL;
+    for (int i = 0; i < SNAPSHOT_SLOT_COUNT; i++) {
+        const SnapshotSlot *slot = &file->slots[i];
+        if (slot->sequence == 0 || slot->checksum != snapshot_checksum(&slot->data) || !snapshot_data_valid(&slot->data)) {
+            continue;
+        }
+        if (latest == NULL || slot->sequence > latest->sequence) {
+            latest = slot;
+        }
+    }
+    return latest;
+}
+
+static void snapshot_crash_handler(int signal_number) {
+    mapped_file_flush(&snapshot_mapped_file);
+    signal(signal_number, SIG_DFL);
+    raise(signal_number);
+}
+
+void snapshot_init() {
+    Snapshots *snapshots = &state->snapshots;
+    if (!mapped_file_open(&snapshot_mapped_file, SNAPSHOT_FILE, sizeof(SnapshotFile))) {
+        printf("snapshot: could not map %s, there will be no crash recovery\n", SNAPSHOT_FILE);
+        return;
+    }
+
+    SnapshotFile *file = get_snapshot_file();
+    if (file->magic != SNAPSHOT_MAGIC || file->version != SNAPSHOT_VERSION) {
+        memset(file, 0, sizeof(SnapshotFile));
+        file->magic = SNAPSHOT_MAGIC;
+        file->version = SNAPSHOT_VERSION;
+        file->clean_exit = true;
+    }
+
+    const SnapshotSlot *latest = get_latest_snapshot(file);
+    snapshots->sequence = (latest != NULL) ? latest->sequence : 0;
+    if (latest != NULL && !file->clean_exit) {
+        state->state = STATE_RESTORE;
+    }
+    file->clean_exit = false;
+
+    for (int i = 0; i < (int)(sizeof(snapshot_crash_signals) / sizeof(snapshot_crash_signals[0])); i++) {
+        signal(snapshot_crash_signals[i], snapshot_crash_handler);
+    }
+
+    snapshot_take(&snapshots->last);
+    snapshots->last_time = GetTime();
+    snapshots->started = true;
+}
+
+// called every frame, nothing happens unless the interval is up and the
+// session changed since the last one
+void snapshot_update() {
+    Snapshots *snapshots = &state->snapshots;
+    if (!snapshots->started || state->state == STATE_RESTORE) {
+        return;
+    }
+    double now = GetTime();
+    if (now - snapshots->last_time < SNAPSHOT_INTERVAL) {
+        return;
+    }
+    snapshots->last_time = now;
+
+    SnapshotData data;
+    snapshot_take(&data);
+    if (memcmp(&data, &snapshots->last, sizeof(SnapshotData)) == 0) {
+        return;
+    }
+    snapshots->last = data;
+
+    snapshots->sequence++;
+    SnapshotSlot *slot = &get_snapshot_file()->slots[snapshots->sequence % SNAPSHOT_SLOT_COUNT];
+    slot->sequence = 0;
+    atomic_signal_fence(memory_order_seq_cst);
+    slot->data = data;
+    slot->checksum = snapshot_checksum(&data);
+    atomic_signal_fence(memory_order_seq_cst);
+    slot->sequence = snapshots->sequence;
+}
+
+void snapshot_restore() {
+    const SnapshotSlot *latest = get_latest_snapshot(get_snapshot_file());
+    if (latest == NULL) {
+        return;
+    }
+    const SnapshotData *data = &latest->data;
+    Engine *engine = &state->engine;
+
+    engine->scale_type = data->scale_type;
+    engine->scale_root = data->scale_root;
+    engine->vibe = data->vibe;
+    engine->vibes_per_chord = data->vibes_per_chord;
+    engine->flats = data->flats;
+    engine->volume_manual = data->volume_manual;
+    engine->filter_cutoff = data->filter_cutoff;
+    engine->filter_resonance = data->filter_resonance;
+    engine->filter_key_tracking = data->filter_key_tracking;
+    memcpy(engine->sequencer, data->sequencer, sizeof(Sequencers));
+    memcpy(engine->sequencer_states, data->sequencer_states, sizeof(engine->sequencer_states));
+    refresh_scale(engine);
+    refresh_time_per_chord_range(engine);
+    set_time_per_chord(engine, data->time_per_chord);
+    engine->chord_idx = 0;
+    engine->chord_timer = 0.0f;
+
+    state->snapshots.last = *data;
+}
+
+// a clean exit leaves nothing to offer next time
+void snapshot_finish() {
+    if (!state->snapshots.started) {
+        return;
+    }
+    get_snapshot_file()->clean_exit = true;
+    mapped_file_close(&snapshot_mapped_file);
+    state->snapshots.started = false;
+}
@@ -0,0 +1,131 @@
+#define SYNTH_LFO_DEPTH 5.0f
+#define SYNTH_LFO_RATE 6.0f
+
+void synth_reset(Synth *synth) {
+    *synth = (Synth){0};
+    synth->prev_step = -1;
+}
+
+bool synth_params_equal(const SynthParams *a, const SynthParams *b) {
+    return (
+        a->root == b->root &&
+        a->third == b->third &&
+        a->fifth == b->fifth &&
+        a->vibe == b->vibe &&
+        a->vibes_per_chord == b->vibes_per_chord &&
+        a->time_per_chord == b->time_per_chord &&
+        a->cutoff == b->cutoff &&
+        a->resonance == b->resonance &&
+        a->key_tracking == b->key_tracking
+    );
+}
+
+uint32 get_chord_frame_count(float time_per_chord) {
+    return (uint32)ceilf(time_per_chord * SAMPLE_RATE);
+}
+
+// renders frames samples of one chord at full volume, starting chord_time
+// seconds into it. while releasing the notes are let go and time stands still
+void synth_render(Synth *synth, const SynthParams *params, float chord_time, bool releasing, int16 *out, uint32 frames) {
+    float sample_rate = SAMPLE_RATE;
+
+    float freq[FREQ_COUNT];
+    get_chord_freqs(params->root, params->third, params->fifth, params->vibe, freq);
+
+    filter_bank_update(&synth->filter, freq, params->cutoff, params->resonance, params->key_tracking, sample_rate);
+
+    float range = params->time_per_chord / params->vibes_per_chord;
+
+    VibeStep steps[16];
+    float fract = -1.0f;
+    int step_count = get_vibe_steps(params->vibe, params->time_per_chord, params->vibes_per_chord, steps, &fract);
+
+    SOFT_ASSERT(step_count > 0);
+    SOFT_ASSERT(fract >= 0.0f);
+
+    if (releasing) {
+        for (int j = 0; j < FREQ_COUNT; j++) {
+            envelope_note_off(&synth->voices[j]);
+        }
+    }
+
+    for (uint32 i = 0; i < frames; i++) {
+        float local_time = releasing ? synth->prev_local_time : fmodf(chord_time + i / sample_rate, range);
+
+        int step = synth->prev_step;
+        for (int j = 0; j < step_count; j++) {
+            if (local_time >= steps[j].start * fract && local_time < steps[j].end * fract) {
+                step = j;
+                break;
+            }
+        }
+
+        // a new step, or the same one again after the vibe wrapped around
+        if (step >= 0 && (step != synth->prev_step || local_time < synth->prev_local_time)) {
+            VibeStep *s = &steps[step];
+            int voice_count = 0;
+            for (int j = 0; j < FREQ_COUNT; j++) {
+                if ((s->bits & (1 << j)) != 0) {
+                    voice_count++;
+                }
+            }
+            float step_end = s->end * fract;
+            float gate_time = ((step_end < range) ? step_end : range) - local_time;
+            for (int j = 0; j < FREQ_COUNT; j++) {
+                if ((s->bits & (1 << j)) != 0) {
+                    envelope_note_on(&synth->voices[j], s->envelope, 1.0f / voice_count, gate_time, sample_rate);
+                } else {
+                    envelope_note_off(&synth->voices[j]);
+                }
+            }
+        }
+        synth->prev_step = step;
+        synth->prev_local_time = local_time;
+
+        float vibrato = sinf(2 * PI * synth->lfo_phase) * SYNTH_LFO_DEPTH;
+
+        float incr[FREQ_COUNT];
+        float tri[FREQ_COUNT];
+
+        for (int j = 0; j < FREQ_COUNT; j++) {
+            float vibrated_freq = freq[j] * (1.0f + vibrato / freq[j]);
+            incr[j] = vibrated_freq / sample_rate;
+            float phase = synth->phase[j];
+            tri[j] = (phase < 0.5f) ? (4.0f * phase - 1.0f) : (3.0f - 4.0f * phase);
+        }
+
+        filter_bank_process(&synth->filter, tri);
+
+        float filtered_sample = 0.0f;
+        for (int j = 0; j < FREQ_COUNT; j++) {
+            filtered_sample += tri[j] * envelope_next(&synth->voices[j]) * synth->voices[j].gain;
+        }
+
+        // releasing notes can overlap the next ones for a moment
+        if (filtered_sample > 1.0f) {
+            filtered_sample = 1.0f;
+        } else if (filtered_sample < -1.0f) {
+            filtered_sample = -1.0f;
+        }
+
+        out[i] = (int16)(32000.0f * filtered_sample);
+
+        for (int j = 0; j < FREQ_COUNT; j++) {
+            synth->phase[j] += incr[j];
+            if (synth->phase[j] > 1.0f) synth->phase[j] -= 1.0f;
+        }
+
+        synth->lfo_phase += SYNTH_LFO_RATE / sample_rate;
+        if (synth->lfo_phase > 1.0f) synth->lfo_phase -= 1.0f;
+    }
+
+    filter_bank_flush_denormals(&synth->filter);
+}
+
+// volume and fade go on after rendering so cached and live audio share them
+void synth_apply_gain(int16 *samples, uint32 frames, Smoother *volume, Smoother *fade) {
+    for (uint32 i = 0; i < frames; i++) {
+        float gain = smoother_next(volume) * smoother_next(fade);
+        samples[i] = (int16)(samples[i] * gain);
+    }
+}
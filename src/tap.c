@@ -0,0 +1,19 @@
+// audio thread side, never blocks or allocates
+void audio_tap_write(AudioTap *tap, const int16 *samples, uint32 count) {
+    uint32 write_idx = atomic_load_explicit(&tap->write_idx, memory_order_relaxed);
+    for (uint32 i = 0; i < count; i++) {
+        tap->samples[(write_idx + i) & AUDIO_TAP_MASK] = samples[i];
+    }
+    atomic_store_explicit(&tap->write_idx, write_idx + count, memory_order_release);
+}
+
+// copies the newest count samples, oldest first. count has to stay well below
+// the capacity so the writer can not lap the part we are copying
+void audio_tap_read(AudioTap *tap, int16 *samples, uint32 count) {
+    SOFT_ASSERT(count <= AUDIO_TAP_CAPACITY / 2);
+    uint32 write_idx = atomic_load_explicit(&tap->write_idx, memory_order_acquire);
+    uint32 start = write_idx - count;
+    for (uint32 i = 0; i < count; i++) {
+        samples[i] = tap->samples[(start + i) & AUDIO_TAP_MASK];
+    }
+}
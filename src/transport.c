@@ -0,0 +1,139 @@
+// the transport. a block is cut wherever a chord ends, each piece is either
+// copied out of the pcm cache or synthesised live
+
+void engine_init(Engine *engine) {
+    *engine = (Engine){0};
+    engine->vibe = VIBE_POLKA;
+    engine->vibes_per_chord = 4;
+    refresh_time_per_chord_range(engine);
+    engine->time_per_chord = get_centralized_time_per_chord(engine);
+    engine->volume_manual = 0.5f;
+    engine->filter_cutoff = FILTER_CUTOFF_DEFAULT;
+    engine->filter_resonance = FILTER_RESONANCE_DEFAULT;
+    engine->filter_key_tracking = FILTER_KEY_TRACKING_DEFAULT;
+    engine->scale_root = NOTE_C;
+    engine->scale_type = SCALE_TYPE_MAJOR;
+    refresh_scale(engine);
+
+    for (int i = 0; i < SEQUENCER_ELEMENTS; i++) {
+        engine->sequencer[i] = SCALE_DEGREE_NONE;
+    }
+
+    engine_reset(engine);
+}
+
+// back to the top of the sequencer with a silent synth and the parameters
+// jumping straight to their targets, the settings stay as they are. two
+// engines reset with the same settings render the same samples
+void engine_reset(Engine *engine) {
+    engine->chord_idx = 0;
+    engine->chord_timer = 0.0f;
+    engine->frame = 0;
+    synth_reset(&engine->synth);
+    memset(engine->smoothers, 0, sizeof(engine->smoothers));
+    publish_param_targets(engine);
+}
+
+// the worker thread is only wanted where there is something playing live
+void engine_start_pcm_cache(Engine *engine) {
+    if (!engine->pcm_cache_started) {
+        pcm_cache_init(&engine->pcm_cache);
+        engine->pcm_cache_started = true;
+    }
+}
+
+void engine_destroy(Engine *engine) {
+    if (engine->pcm_cache_started) {
+        pcm_cache_destroy(&engine->pcm_cache);
+        engine->pcm_cache_started = false;
+    }
+}
+
+// fills frames samples and moves the sequencer along. returns whether the
+// transport is playing, it keeps sounding for a moment after a stop
+bool engine_render(Engine *engine, int16 *out, uint32 frames) {
+    flush_denormals();
+
+    float sample_rate = SAMPLE_RATE;
+    Smoother *smoothers = engine->smoothers;
+
+    for (int i = 0; i < PARAM_COUNT; i++) {
+        float target = atomic_load_explicit(&engine->param_targets[i], memory_order_relaxed);
+        smoother_begin_block(&smoothers[i], target, param_ramp_times[i], frames, sample_rate);
+    }
+
+    // after a stop the notes keep ringing out while the fade goes down
+    bool playing = engine->playing && is_sequencer_active(engine);
+    bool fading_out = !playing && smoothers[PARAM_FADE].value > 0.0f;
+
+    if (!playing && !fading_out) {
+        engine->chord_timer = 0.0f;
+        for (int i = 0; i < PARAM_COUNT; i++) {
+            smoother_end_block(&smoothers[i]);
+        }
+        memset(out, 0, frames * sizeof(int16));
+        engine->frame += frames;
+        return false;
+    }
+
+    float time_per_chord = smoothers[PARAM_TEMPO].end;
+    float cutoff = smoothers[PARAM_CUTOFF].end;
+    bool use_pcm_cache = engine->use_pcm_cache && engine->pcm_cache_started;
+
+    uint32 done = 0;
+    while (done < frames) {
+        int16 *segment = out + done;
+        uint32 count = frames - done;
+
+        Chord chord = make_chord(engine->scale, engine->scale_root, engine->sequencer[engine->chord_idx]);
+        if (chord.type == CHORD_TYPE_NONE) {
+            memset(segment, 0, count * sizeof(int16));
+            break;
+        }
+
+        SynthParams params = get_synth_params(engine, chord, time_per_chord, cutoff);
+
+        if (fading_out) {
+            if (engine->mute) {
+                memset(segment, 0, count * sizeof(int16));
+            } else {
+                synth_render(&engine->synth, &params, engine->chord_timer, true, segment, count);
+            }
+            break;
+        }
+
+        uint32 position = (uint32)(engine->chord_timer * sample_rate + 0.5f);
+        uint32 chord_frame_count = get_chord_frame_count(time_per_chord);
+        uint32 left = (chord_frame_count > position) ? chord_frame_count - position : 1;
+        if (count > left) {
+            count = left;
+        }
+
+        if (engine->chord_callback != NULL) {
+            engine->chord_callback(engine->chord_callback_data, &params, position, count, engine->frame + done);
+        }
+
+        if (engine->mute) {
+            memset(segment, 0, count * sizeof(int16));
+        } else {
+            bool cached = use_pcm_cache && pcm_cache_read(&engine->pcm_cache, &params, position, segment, count);
+            if (!cached) {
+                synth_render(&engine->synth, &params, engine->chord_timer, false, segment, count);
+            }
+        }
+
+        done += count;
+        engine->chord_timer += count / sample_rate;
+        if (count == left) {
+            progress(engine);
+        }
+    }
+
+    synth_apply_gain(out, frames, &smoothers[PARAM_VOLUME], &smoothers[PARAM_FADE]);
+
+    for (int i = 0; i < PARAM_COUNT; i++) {
+        smoother_end_block(&smoothers[i]);
+    }
+    engine->frame += frames;
+    return playing;
+}
@@ -0,0 +1,91 @@
+// 16 bit pcm wav written as it is produced, the sizes in the header are
+// left at zero and filled in on close, so memory use does not depend on length
+
+#define WAV_WRITER_BUFFER_FRAMES 16384
+#define WAV_HEADER_SIZE 44
+
+typedef struct WavWriter {
+    FILE *file;
+    uint32 sample_rate;
+    uint16 channels;
+    uint32 data_size;
+    uint32 buffered;
+    int16 buffer[WAV_WRITER_BUFFER_FRAMES];
+} WavWriter;
+
+static void wav_put_u16(uint8 *p, uint16 v) {
+    p[0] = v & 0xff;
+    p[1] = (v >> 8) & 0xff;
+}
+
+static void wav_put_u32(uint8 *p, uint32 v) {
+    p[0] = v & 0xff;
+    p[1] = (v >> 8) & 0xff;
+    p[2] = (v >> 16) & 0xff;
+    p[3] = (v >> 24) & 0xff;
+}
+
+static void wav_write_header(WavWriter *writer) {
+    uint16 block_align = writer->channels * sizeof(int16);
+    uint8 header[WAV_HEADER_SIZE];
+
+    memcpy(header + 0, "RIFF", 4);
+    wav_put_u32(header + 4, 36 + writer->data_size);
+    memcpy(header + 8, "WAVE", 4);
+    memcpy(header + 12, "fmt ", 4);
+    wav_put_u32(header + 16, 16);
+    wav_put_u16(header + 20, 1);
+    wav_put_u16(header + 22, writer->channels);
+    wav_put_u32(header + 24, writer->sample_rate);
+    wav_put_u32(header + 28, writer->sample_rate * block_align);
+    wav_put_u16(header + 32, block_align);
+    wav_put_u16(header + 34, 16);
+    memcpy(header + 36, "data", 4);
+    wav_put_u32(header + 40, writer->data_size);
+
+    fwrite(header, 1, WAV_HEADER_SIZE, writer->file);
+}
+
+bool wav_writer_open(WavWriter *writer, const char *file_name, uint32 sample_rate, uint16 channels) {
+    writer->file = fopen(file_name, "wb");
+    if (writer->file == NULL) {
+        return false;
+    }
+    writer->sample_rate = sample_rate;
+    writer->channels = channels;
+    writer->data_size = 0;
+    writer->buffered = 0;
+    wav_write_header(writer);
+    return true;
+}
+
+static void wav_writer_flush(WavWriter *writer) {
+    // wav is little endian, so are all the machines this runs on
+    fwrite(writer->buffer, sizeof(int16), writer->buffered, writer->file);
+    writer->data_size += writer->buffered * sizeof(int16);
+    writer->buffered = 0;
+}
+
+void wav_writer_write(WavWriter *writer, const int16 *samples, uint32 count) {
+    while (count > 0) {
+        uint32 space = WAV_WRITER_BUFFER_FRAMES - writer->buffered;
+        uint32 n = (count < space) ? count : space;
+        memcpy(writer->buffer + writer->buffered, samples, n * sizeof(int16));
+        writer->buffered += n;
+        samples += n;
+        count -= n;
+        if (writer->buffered == WAV_WRITER_BUFFER_FRAMES) {
+            wav_writer_flush(writer);
+        }
+    }
+}
+
+bool wav_writer_close(WavWriter *writer) {
+    wav_writer_flush(writer);
+    fseek(writer->file, 0, SEEK_SET);
+    wav_write_header(writer);
+    bool ok = !ferror(writer->file);
+    ok = (fclose(writer->file) == 0) && ok;
+    writer->file = NULL;
+    return ok;
+}
@@ -0,0 +1,254 @@
+#include "engine.h"
+#include "debug.h"
+
+#include <stdio.h>
+
+// golden audio. renders a fixed progression through the engine for every
+// vibe in a few keys and tempos and compares it with tests/golden.txt.
+// identical samples match by hash. when they are not identical, a changed
+// compiler or vector path can still be within rounding of the reference. the
+// render is cut into equal segments that cover every sample, and the rms of
+// each has to stay 60 dB above how far it moved from the reference.
+// after a change that is meant to sound different:
+//     build/golden --update tests/golden.txt
+
+#define GOLDEN_BLOCK_FRAMES 512
+#define GOLDEN_SEGMENT_COUNT 256
+#define GOLDEN_SNR_DB 60.0
+#define GOLDEN_TAIL_TIME 0.25f
+#define GOLDEN_NAME_CAPACITY 64
+#define GOLDEN_MAX_SCENARIOS 128
+
+typedef struct GoldenKey {
+    uint8 root;
+    uint8 scale_type;
+    const char *name;
+} GoldenKey;
+
+typedef struct Golden {
+    char name[GOLDEN_NAME_CAPACITY];
+    uint32 frame_count;
+    uint64 hash;
+    double segment_rms[GOLDEN_SEGMENT_COUNT];
+} Golden;
+
+static const GoldenKey golden_keys[] = {
+    { NOTE_C, SCALE_TYPE_MAJOR, "c_major" },
+    { NOTE_F_SHARP, SCALE_TYPE_MINOR, "f#_minor" },
+    { NOTE_B_FLAT, SCALE_TYPE_DORIAN, "bb_dorian" },
+};
+
+static const char *golden_vibe_names[VIBE_COUNT] = {
+    [VIBE_POLKA] = "polka",
+    [VIBE_SWING] = "swing",
+    [VIBE_WALTZ] = "waltz",
+    [VIBE_CHORD] = "chord",
+    [VIBE_ROOT] = "root",
+    [VIBE_THIRD] = "third",
+    [VIBE_FIFTH] = "fifth",
+};
+
+static const uint8 golden_progression[] = {
+    SCALE_DEGREE_I, SCALE_DEGREE_VI, SCALE_DEGREE_IV, SCALE_DEGREE_V,
+};
+
+// fnv-1a over the samples as little endian bytes
+static uint64 golden_hash(const int16 *samples, uint32 count) {
+    uint64 hash = 0xcbf29ce484222325ull;
+    for (uint32 i = 0; i < count; i++) {
+        uint16 sample = (uint16)samples[i];
+        hash = (hash ^ (sample & 0xff)) * 0x100000001b3ull;
+        hash = (hash ^ (sample >> 8)) * 0x100000001b3ull;
+    }
+    return hash;
+}
+
+// the progression once through on the first row, then a stop and the fade
+static void golden_render(Engine *engine, uint8 vibe, const GoldenKey *key, bool fast, Golden *golden) {
+    engine_init(engine);
+    engine->vibe = vibe;
+    engine->vibes_per_chord = 1;
+    engine->scale_root = key->root;
+    engine->scale_type = key->scale_type;
+    refresh_scale(engine);
+    refresh_time_per_chord_range(engine);
+    engine->time_per_chord = fast ? engine->min_time_per_chord : engine->max_time_per_chord;
+
+    for (int i = 0; i < (int)sizeof(golden_progression); i++) {
+        engine->sequencer[i] = golden_progression[i];
+    }
+    engine->sequencer_states[0] = true;
+    engine->playing = true;
+    engine_reset(engine);
+
+    uint32 play_frames = sizeof(golden_progression) * get_chord_frame_count(engine->time_per_chord);
+    uint32 tail_frames = (uint32)(GOLDEN_TAIL_TIME * SAMPLE_RATE);
+    uint32 frame_count = play_frames + tail_frames;
+    int16 *samples = (int16 *)malloc((frame_count + GOLDEN_BLOCK_FRAMES) * sizeof(int16));
+
+    uint32 done = 0;
+    while (done < frame_count) {
+        if (done >= play_frames && engine->playing) {
+            engine->playing = false;
+            publish_param_targets(engine);
+        }
+        engine_render(engine, samples + done, GOLDEN_BLOCK_FRAMES);
+        done += GOLDEN_BLOCK_FRAMES;
+    }
+
+    snprintf(golden->name, GOLDEN_NAME_CAPACITY, "%s/%s/%s", golden_vibe_names[vibe], key->name, fast ? "fast" : "slow");
+    golden->frame_count = frame_count;
+    golden->hash = golden_hash(samples, frame_count);
+    for (int i = 0; i < GOLDEN_SEGMENT_COUNT; i++) {
+        uint32 start = (uint32)((uint64)i * frame_count / GOLDEN_SEGMENT_COUNT);
+        uint32 end = (uint32)((uint64)(i + 1) * frame_count / GOLDEN_SEGMENT_COUNT);
+        double energy = 0.0;
+        for (uint32 j = start; j < end; j++) {
+            energy += (double)samples[j] * samples[j];
+        }
+        golden->segment_rms[i] = (end > start) ? sqrt(energy / (end - start)) : 0.0;
+    }
+
+    free(samples);
+}
+
+static int golden_render_all(Golden *goldens) {
+    Engine *engine = (Engine *)calloc(1, sizeof(Engine));
+    int count = 0;
+    for (int vibe = 0; vibe < VIBE_COUNT; vibe++) {
+        for (int key = 0; key < (int)(sizeof(golden_keys) / sizeof(golden_keys[0])); key++) {
+            for (int fast = 0; fast < 2; fast++) {
+                ASSERT(count < GOLDEN_MAX_SCENARIOS);
+                golden_render(engine, vibe, &golden_keys[key], fast, &goldens[count++]);
+            }
+        }
+    }
+    engine_destroy(engine);
+    free(engine);
+    return count;
+}
+
+static bool golden_save(const char *file_name, const Golden *goldens, int count) {
+    FILE *file = fopen(file_name, "w");
+    if (file == NULL) {
+        return false;
+    }
+    fprintf(file, "# name frames fnv1a %i segment rms, written by build/golden --update\n", GOLDEN_SEGMENT_COUNT);
+    for (int i = 0; i < count; i++) {
+        const Golden *golden = &goldens[i];
+        fprintf(file, "%s %u %016llx", golden->name, golden->frame_count, (unsigned long long)golden->hash);
+        for (int j = 0; j < GOLDEN_SEGMENT_COUNT; j++) {
+            fprintf(file, " %.3f", golden->segment_rms[j]);
+        }
+        fprintf(file, "\n");
+    }
+    return fclose(file) == 0;
+}
+
+static int golden_load(const char *file_name, Golden *goldens) {
+    FILE *file = fopen(file_name, "r");
+    if (file == NULL) {
+        return -1;
+    }
+
+    int count = 0;
+    int c;
+    while ((c = fgetc(file)) != EOF && count < GOLDEN_MAX_SCENARIOS) {
+        if (c == '#') {
+            while ((c = fgetc(file)) != EOF && c != '\n');
+            continue;
+        }
+        if (c == '\n') {
+            continue;
+        }
+        ungetc(c, file);
+
+        Golden *golden = &goldens[count];
+        unsigned long long hash;
+        if (fscanf(file, "%63s %u %llx", golden->name, &golden->frame_count, &hash) != 3) {
+            break;
+        }
+        golden->hash = hash;
+        for (int i = 0; i < GOLDEN_SEGMENT_COUNT; i++) {
+            if (fscanf(file, "%lf", &golden->segment_rms[i]) != 1) {
+                fclose(file);
+                return -1;
+            }
+        }
+        count++;
+    }
+
+    fclose(file);
+    return count;
+}
+
+static double golden_snr(const Golden *reference, const Golden *rendered) {
+    double signal = 0.0;
+    double noise = 0.0;
+    for (int i = 0; i < GOLDEN_SEGMENT_COUNT; i++) {
+        double d = rendered->segment_rms[i] - reference->segment_rms[i];
+        signal += reference->segment_rms[i] * reference->segment_rms[i];
+        noise += d * d;
+    }
+    if (noise == 0.0) {
+        return INFINITY;
+    }
+    return 10.0 * log10(signal / noise);
+}
+
+int main(int argc, char **argv) {
+    bool update = argc > 2 && strcmp(argv[1], "--update") == 0;
+    const char *file_name = update ? argv[2] : (argc > 1 ? argv[1] : "tests/golden.txt");
+
+    static Golden rendered[GOLDEN_MAX_SCENARIOS];
+    static Golden reference[GOLDEN_MAX_SCENARIOS];
+    int rendered_count = golden_render_all(rendered);
+
+    if (update) {
+        if (!golden_save(file_name, rendered, rendered_count)) {
+            printf("golden: could not write %s\n", file_name);
+            return 1;
+        }
+        printf("golden: wrote %i scenarios to %s\n", rendered_count, file_name);
+        return 0;
+    }
+
+    int reference_count = golden_load(file_name, reference);
+    if (reference_count < 0) {
+        printf("golden: could not read %s\n", file_name);
+        return 1;
+    }
+
+    int failed = 0;
+    for (int i = 0; i < rendered_count; i++) {
+        const Golden *golden = &rendered[i];
+        const Golden *match = NULL;
+        for (int j = 0; j < reference_count; j++) {
+            if (strcmp(reference[j].name, golden->name) == 0) {
+                match = &reference[j];
+                break;
+            }
+        }
+
+        if (match == NULL) {
+            printf("FAIL %s: no reference\n", golden->name);
+            failed++;
+        } else if (match->frame_count != golden->frame_count) {
+            printf("FAIL %s: %u frames, expected %u\n", golden->name, golden->frame_count, match->frame_count);
+            failed++;
+        } else if (match->hash == golden->hash) {
+            printf("ok   %s\n", golden->name);
+        } else {
+            double snr = golden_snr(match, golden);
+            if (snr >= GOLDEN_SNR_DB) {
+                printf("ok   %s (not identical, %.1f dB snr)\n", golden->name, snr);
+            } else {
+                printf("FAIL %s: %.1f dB snr, at least %.0f needed\n", golden->name, snr, GOLDEN_SNR_DB);
+                failed++;
+            }
+        }
+    }
+
+    printf("golden: %i of %i scenarios passed\n", rendered_count - failed, rendered_count);
+    return failed > 0;
+}
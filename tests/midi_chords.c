@@ -0,0 +1,330 @@
+#include "engine.h"
+#include "debug.h"
+
+#include <stdio.h>
+
+// midi import. small files are written in memory and the chords read back
+// from them compared with the ones that went in. the voicings share common
+// tones on purpose, and strike them in different orders within a tick
+
+#include "midi_import.c"
+
+#define MIDI_TEST_MAX_EVENTS 64
+#define MIDI_TEST_MAX_TRACKS 4
+#define MIDI_TEST_MAX_CHORDS 8
+#define MIDI_TEST_FILE_CAPACITY 4096
+#define MIDI_TEST_BAR 480
+
+typedef struct MidiTestEvent {
+    uint32 tick;
+    bool on;
+    uint8 note;
+} MidiTestEvent;
+
+typedef struct MidiTestTrack {
+    MidiTestEvent events[MIDI_TEST_MAX_EVENTS];
+    int event_count;
+} MidiTestTrack;
+
+typedef struct MidiTestCase {
+    const char *name;
+    MidiTestTrack tracks[MIDI_TEST_MAX_TRACKS];
+    int track_count;
+    Chord expected[MIDI_TEST_MAX_CHORDS];
+    int expected_count;
+} MidiTestCase;
+
+typedef struct MidiTestFile {
+    uint8 data[MIDI_TEST_FILE_CAPACITY];
+    uint32 size;
+} MidiTestFile;
+
+static const Chord chord_c = { .root = NOTE_C, .type = CHORD_TYPE_MAJOR };
+static const Chord chord_f = { .root = NOTE_F, .type = CHORD_TYPE_MAJOR };
+static const Chord chord_g = { .root = NOTE_G, .type = CHORD_TYPE_MAJOR };
+static const Chord chord_a_minor = { .root = NOTE_A, .type = CHORD_TYPE_MINOR };
+
+static void midi_test_put(MidiTestFile *file, const void *bytes, uint32 count) {
+    ASSERT(file->size + count <= MIDI_TEST_FILE_CAPACITY);
+    memcpy(file->data + file->size, bytes, count);
+    file->size += count;
+}
+
+static void midi_test_put_u32(MidiTestFile *file, uint32 value) {
+    uint8 bytes[4] = { value >> 24, (value >> 16) & 0xff, (value >> 8) & 0xff, value & 0xff };
+    midi_test_put(file, bytes, 4);
+}
+
+static void midi_test_put_variable(MidiTestFile *file, uint32 value) {
+    uint8 bytes[5];
+    int count = 0;
+    bytes[count++] = value & 0x7f;
+    while ((value >>= 7) > 0) {
+        bytes[count++] = 0x80 | (value & 0x7f);
+    }
+    while (count > 0) {
+        midi_test_put(file, &bytes[--count], 1);
+    }
+}
+
+// the events go in the order they are listed, ticks never go back
+static void midi_test_write(const MidiTestCase *test, MidiTestFile *file) {
+    file->size = 0;
+    uint8 header[] = { 'M', 'T', 'h', 'd', 0, 0, 0, 6, 0, 1, 0, test->track_count, MIDI_TEST_BAR >> 8, MIDI_TEST_BAR & 0xff };
+    midi_test_put(file, header, sizeof(header));
+
+    for (int i = 0; i < test->track_count; i++) {
+        const MidiTestTrack *track = &test->tracks[i];
+        midi_test_put(file, "MTrk", 4);
+        uint32 length_offset = file->size;
+        midi_test_put_u32(file, 0);
+
+        uint32 tick = 0;
+        for (int j = 0; j < track->event_count; j++) {
+            const MidiTestEvent *event = &track->events[j];
+            ASSERT(event->tick >= tick);
+            midi_test_put_variable(file, event->tick - tick);
+            tick = event->tick;
+            uint8 bytes[3] = { event->on ? 0x90 : 0x80, event->note, event->on ? 100 : 0 };
+            midi_test_put(file, bytes, 3);
+        }
+        uint8 end_of_track[] = { 0, 0xff, 0x2f, 0 };
+        midi_test_put(file, end_of_track, sizeof(end_of_track));
+
+        uint32 length = file->size - length_offset - 4;
+        uint8 *p = file->data + length_offset;
+        p[0] = length >> 24;
+        p[1] = (length >> 16) & 0xff;
+        p[2] = (length >> 8) & 0xff;
+        p[3] = length & 0xff;
+    }
+}
+
+static void midi_test_add(MidiTestTrack *track, uint32 tick, bool on, uint8 note) {
+    ASSERT(track->event_count < MIDI_TEST_MAX_EVENTS);
+    track->events[track->event_count++] = (MidiTestEvent){ tick, on, note };
+}
+
+// notes struck together on the start of the bar and let go on its end,
+// in the order given
+static void midi_test_block(MidiTestTrack *track, uint32 bar, const uint8 *notes, int note_count) {
+    for (int i = 0; i < note_count; i++) {
+        midi_test_add(track, bar * MIDI_TEST_BAR, true, notes[i]);
+    }
+    for (int i = 0; i < note_count; i++) {
+        midi_test_add(track, (bar + 1) * MIDI_TEST_BAR, false, notes[i]);
+    }
+}
+
+// I IV V I, every chord starting with the note it has in common with the
+// chord before
+static const uint8 progression_notes[4][3] = {
+    { 60, 64, 67 },
+    { 60, 65, 69 },
+    { 67, 71, 62 },
+    { 60, 64, 67 },
+};
+
+static void midi_test_common_tones(MidiTestCase *test) {
+    test->name = "common tones first";
+    test->track_count = 1;
+    for (int bar = 0; bar < 4; bar++) {
+        midi_test_block(&test->tracks[0], bar, progression_notes[bar], 3);
+    }
+    test->expected[0] = chord_c;
+    test->expected[1] = chord_f;
+    test->expected[2] = chord_g;
+    test->expected[3] = chord_c;
+    test->expected_count = 4;
+}
+
+// the note offs of one bar come after the note ons of the next
+static void midi_test_offs_last(MidiTestCase *test) {
+    test->name = "note offs after the next chord";
+    test->track_count = 1;
+    MidiTestTrack *track = &test->tracks[0];
+    for (int bar = 0; bar < 4; bar++) {
+        for (int i = 0; i < 3; i++) {
+            midi_test_add(track, bar * MIDI_TEST_BAR, true, progression_notes[bar][i]);
+        }
+        if (bar > 0) {
+            for (int i = 0; i < 3; i++) {
+                midi_test_add(track, bar * MIDI_TEST_BAR, false, progression_notes[bar - 1][i]);
+            }
+        }
+    }
+    for (int i = 0; i < 3; i++) {
+        midi_test_add(track, 4 * MIDI_TEST_BAR, false, progression_notes[3][i]);
+    }
+    test->expected[0] = chord_c;
+    test->expected[1] = chord_f;
+    test->expected[2] = chord_g;
+    test->expected[3] = chord_c;
+    test->expected_count = 4;
+}
+
+// the root on a track of its own, the rest of the chord on another
+static void midi_test_split_tracks(MidiTestCase *test) {
+    test->name = "split over tracks";
+    test->track_count = 2;
+    for (int bar = 0; bar < 4; bar++) {
+        midi_test_block(&test->tracks[0], bar, &progression_notes[bar][0], 1);
+        midi_test_block(&test->tracks[1], bar, &progression_notes[bar][1], 2);
+    }
+    test->expected[0] = chord_c;
+    test->expected[1] = chord_f;
+    test->expected[2] = chord_g;
+    test->expected[3] = chord_c;
+    test->expected_count = 4;
+}
+
+// C held on through the F chord, only the other two notes change
+static void midi_test_held_common_tone(MidiTestCase *test) {
+    test->name = "held common tone";
+    test->track_count = 1;
+    MidiTestTrack *track = &test->tracks[0];
+    midi_test_add(track, 0, true, 60);
+    midi_test_add(track, 0, true, 64);
+    midi_test_add(track, 0, true, 67);
+    midi_test_add(track, MIDI_TEST_BAR, false, 64);
+    midi_test_add(track, MIDI_TEST_BAR, false, 67);
+    midi_test_add(track, MIDI_TEST_BAR, true, 65);
+    midi_test_add(track, MIDI_TEST_BAR, true, 69);
+    midi_test_add(track, 2 * MIDI_TEST_BAR, false, 60);
+    midi_test_add(track, 2 * MIDI_TEST_BAR, false, 65);
+    midi_test_add(track, 2 * MIDI_TEST_BAR, false, 69);
+    test->expected[0] = chord_c;
+    test->expected[1] = chord_f;
+    test->expected_count = 2;
+}
+
+// one note at a time, each let go before the next
+static void midi_test_arpeggio(MidiTestCase *test) {
+    test->name = "arpeggio";
+    test->track_count = 1;
+    MidiTestTrack *track = &test->tracks[0];
+    static const uint8 notes[] = { 57, 60, 64, 60, 65, 69 };
+    for (int i = 0; i < (int)sizeof(notes); i++) {
+        uint32 tick = i * (MIDI_TEST_BAR / 4);
+        midi_test_add(track, tick, true, notes[i]);
+        midi_test_add(track, tick + (MIDI_TEST_BAR / 4), false, notes[i]);
+    }
+    test->expected[0] = chord_a_minor;
+    test->expected[1] = chord_f;
+    test->expected_count = 2;
+}
+
+// a melody note over a held chord is not a chord change
+static void midi_test_passing_note(MidiTestCase *test) {
+    test->name = "passing note";
+    test->track_count = 1;
+    MidiTestTrack *track = &test->tracks[0];
+    static const uint8 c_major[] = { 60, 64, 67 };
+    static const uint8 g_major[] = { 67, 71, 62 };
+    for (int i = 0; i < 3; i++) {
+        midi_test_add(track, 0, true, c_major[i]);
+    }
+    midi_test_add(track, MIDI_TEST_BAR / 2, true, 74);
+    midi_test_add(track, MIDI_TEST_BAR * 3 / 4, false, 74);
+    for (int i = 0; i < 3; i++) {
+        midi_test_add(track, MIDI_TEST_BAR, false, c_major[i]);
+    }
+    midi_test_block(track, 1, g_major, 3);
+    test->expected[0] = chord_c;
+    test->expected[1] = chord_g;
+    test->expected_count = 2;
+}
+
+// I I IV V, the chord struck again is a cell of its own
+static void midi_test_repeated_chord(MidiTestCase *test) {
+    test->name = "repeated chord";
+    test->track_count = 1;
+    static const uint8 bars[4] = { 0, 0, 1, 2 };
+    for (int bar = 0; bar < 4; bar++) {
+        midi_test_block(&test->tracks[0], bar, progression_notes[bars[bar]], 3);
+    }
+    test->expected[0] = chord_c;
+    test->expected[1] = chord_c;
+    test->expected[2] = chord_f;
+    test->expected[3] = chord_g;
+    test->expected_count = 4;
+}
+
+static void (*midi_tests[])(MidiTestCase *test) = {
+    midi_test_common_tones,
+    midi_test_offs_last,
+    midi_test_split_tracks,
+    midi_test_held_common_tone,
+    midi_test_arpeggio,
+    midi_test_passing_note,
+    midi_test_repeated_chord,
+};
+
+#define MIDI_TEST_COUNT (sizeof(midi_tests) / sizeof(midi_tests[0]))
+
+static bool midi_test_run(const MidiTestCase *test) {
+    static MidiTestFile file;
+    midi_test_write(test, &file);
+
+    Chord chords[MIDI_TEST_MAX_CHORDS];
+    int chord_count = midi_read_chords(file.data, file.size, chords, MIDI_TEST_MAX_CHORDS);
+    bool ok = chord_count == test->expected_count;
+    for (int i = 0; ok && i < chord_count; i++) {
+        ok = chords[i].root == test->expected[i].root && chords[i].type == test->expected[i].type;
+    }
+    if (ok) {
+        printf("ok   %s\n", test->name);
+        return true;
+    }
+
+    printf("FAIL %s: read", test->name);
+    for (int i = 0; i < chord_count; i++) {
+        printf(" %i/%i", chords[i].root, chords[i].type);
+    }
+    printf(", expected");
+    for (int i = 0; i < test->expected_count; i++) {
+        printf(" %i/%i", test->expected[i].root, test->expected[i].type);
+    }
+    printf("\n");
+    return false;
+}
+
+int main() {
+    int failed = 0;
+    for (int i = 0; i < (int)MIDI_TEST_COUNT; i++) {
+        MidiTestCase test;
+        memset(&test, 0, sizeof(MidiTestCase));
+        midi_tests[i](&test);
+        if (!midi_test_run(&test)) {
+            failed++;
+        }
+    }
+
+    // a header that claims to run past the end of the file
+    static const uint8 long_header[] = { 'M', 'T', 'h', 'd', 0xff, 0xff, 0xff, 0xf0, 0, 0, 0, 1, 0, 96 };
+    Chord chords[MIDI_TEST_MAX_CHORDS];
+    int chord_count = midi_read_chords(long_header, sizeof(long_header), chords, MIDI_TEST_MAX_CHORDS);
+    if (chord_count == -1) {
+        printf("ok   header longer than the file\n");
+    } else {
+        printf("FAIL header longer than the file: read %i chords, expected -1\n", chord_count);
+        failed++;
+    }
+
+    // and the key the progression is taken to be in
+    MidiTestCase test;
+    memset(&test, 0, sizeof(MidiTestCase));
+    midi_test_common_tones(&test);
+    uint8 scale_root = 0;
+    uint8 scale_type = 0;
+    midi_find_key(test.expected, test.expected_count, &scale_root, &scale_type);
+    if (scale_root == NOTE_C && scale_type == SCALE_TYPE_MAJOR) {
+        printf("ok   key of I IV V I\n");
+    } else {
+        printf("FAIL key of I IV V I: %i/%i, expected %i/%i\n", scale_root, scale_type, NOTE_C, SCALE_TYPE_MAJOR);
+        failed++;
+    }
+
+    printf("midi import: %i of %i cases passed\n", (int)MIDI_TEST_COUNT + 1 - failed, (int)MIDI_TEST_COUNT + 1);
+    return (failed == 0) ? 0 : 1;
+}